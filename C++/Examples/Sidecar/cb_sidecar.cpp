@@ -0,0 +1,178 @@
+/*
+  Copyright © CloudBackend AB 2025.
+*/
+
+/**
+ * Sidecar daemon: logs in once and serves the container listings of its
+ * session to the local processes connecting to its Unix socket, see
+ * cb_sidecar_client.cpp. All clients thereby share a single login, the
+ * connections of that session, and its cache.
+ *
+ * Protocol, one request per connection:
+ *   request:  "query <containerId>\n", 0 denoting the root container
+ *   response: "OK <count>\n" followed by <count> lines of
+ *             "<C|O>\t<id>\t<name>\n", or "ERR <code> <reason>\n"
+ * Backslashes, tabs and line breaks in names are escaped as "\\", "\t", "\n"
+ * and "\r". A client that does not send its request within a few seconds is
+ * disconnected, and a client beyond the maximum of concurrent ones is
+ * answered with "ERR 503 Service Unavailable\n".
+ *
+ * usage: cb_sidecar [socket path]
+ */
+
+#include "cbe/Account.h"
+#include "cbe/CloudBackend.h"
+#include "cbe/Container.h"
+#include "cbe/Filter.h"
+#include "cbe/Item.h"
+#include "cbe/QueryChainSync.h"
+#include "cbe/QueryResult.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "user_credentials.cpp"  // file is located in this folder
+
+namespace {
+
+constexpr int maxClients = 64;
+constexpr int clientTimeoutSeconds = 5;
+
+bool writeAll(int fd, const std::string& data) {
+  std::size_t written = 0;
+  while (written < data.size()) {
+    const auto n = ::write(fd, data.data() + written, data.size() - written);
+    if (n <= 0) {
+      return false;
+    }
+    written += static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+std::string readLine(int fd) {
+  std::string line{};
+  char c{};
+  while (line.size() < 256 && ::read(fd, &c, 1) == 1 && c != '\n') {
+    line += c;
+  }
+  return line;
+}
+
+// Keeps the fields of the response lines apart
+std::string escaped(const std::string& name) {
+  std::string result{};
+  result.reserve(name.size());
+  for (const char c : name) {
+    switch (c) {
+      case '\\': result += "\\\\"; break;
+      case '\t': result += "\\t"; break;
+      case '\n': result += "\\n"; break;
+      case '\r': result += "\\r"; break;
+      default:   result += c;
+    }
+  }
+  return result;
+}
+
+std::string query(cbe::CloudBackend& cloudBackend,
+                  cbe::ContainerId   rootId,
+                  const std::string& request) {
+  std::istringstream in{request};
+  std::string command{};
+  cbe::ContainerId containerId{};
+  if (!(in >> command >> containerId) || command != "query") {
+    return "ERR 400 Bad Request\n";
+  }
+  cbe::CloudBackend::QueryJoinError error;
+  auto result = cloudBackend.query(containerId ? containerId : rootId,
+                                   cbe::Filter{}, error).getQueryResult();
+  if (error) {
+    return "ERR " + std::to_string(error.error.errorCode) + ' ' +
+           error.error.reason + '\n';
+  }
+  std::ostringstream out{};
+  const auto items = result.getItemsSnapshot();
+  out << "OK " << items.size() << '\n';
+  for (const auto& item : items) {
+    out << (item.type() == cbe::ItemType::Container ? 'C' : 'O') << '\t'
+        << item.id() << '\t' << escaped(item.name()) << '\n';
+  }
+  return out.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  const std::string socketPath = argc > 1 ? argv[1] : "/tmp/cb_sidecar.sock";
+  std::signal(SIGPIPE, SIG_IGN);
+
+  cbe::CloudBackend::LogInError logInError;
+  cbe::CloudBackend cloudBackend = cbe::CloudBackend::logIn(username,
+                                                            password,
+                                                            tenant,
+                                                            client,
+                                                            logInError);
+  if (logInError) {
+    std::cout << "Error, login failed! \nError info=" << logInError
+              << std::endl;
+    return 1;
+  }
+  const cbe::ContainerId rootId = cloudBackend.account().rootContainer().id();
+
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socketPath.c_str(),
+               sizeof(address.sun_path) - 1);
+  ::unlink(socketPath.c_str());
+  if (listener < 0 ||
+      ::bind(listener, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) < 0 ||
+      ::listen(listener, 64) < 0) {
+    std::cout << "Error, cannot listen on " << socketPath << ": "
+              << std::strerror(errno) << std::endl;
+    cloudBackend.terminate();
+    return 2;
+  }
+  std::cout << "Serving " << username << " on " << socketPath << std::endl;
+
+  std::atomic<int> clients{0};
+  for (;;) {
+    const int connection = ::accept(listener, nullptr, nullptr);
+    if (connection < 0) {
+      continue;
+    }
+    // A client that neither sends nor reads does not hold its thread forever
+    timeval timeout{};
+    timeout.tv_sec = clientTimeoutSeconds;
+    ::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                 sizeof(timeout));
+    ::setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                 sizeof(timeout));
+    if (++clients > maxClients) {
+      --clients;
+      writeAll(connection, "ERR 503 Service Unavailable\n");
+      ::close(connection);
+      continue;
+    }
+    // The SDK calls are thread-safe, each client is served on its own thread
+    std::thread{[&cloudBackend, &clients, rootId, connection]() {
+      writeAll(connection, query(cloudBackend, rootId, readLine(connection)));
+      ::close(connection);
+      --clients;
+    }}.detach();
+  }
+}
@@ -0,0 +1,50 @@
+/*
+  Copyright © CloudBackend AB 2025.
+*/
+
+/**
+ * Client of the sidecar daemon cb_sidecar: lists a container through the
+ * session of the daemon, without logging in itself.
+ *
+ * usage: cb_sidecar_client [containerId] [socket path]
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+  const std::string containerId = argc > 1 ? argv[1] : "0";
+  const std::string socketPath = argc > 2 ? argv[2] : "/tmp/cb_sidecar.sock";
+
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socketPath.c_str(),
+               sizeof(address.sun_path) - 1);
+  if (fd < 0 ||
+      ::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address)) < 0) {
+    std::cout << "Error, no sidecar on " << socketPath << ": "
+              << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  const std::string request = "query " + containerId + '\n';
+  if (::write(fd, request.data(), request.size()) !=
+      static_cast<ssize_t>(request.size())) {
+    std::cout << "Error, request not sent" << std::endl;
+    return 1;
+  }
+  char buffer[4096];
+  ssize_t n{};
+  while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+    std::cout.write(buffer, n);
+  }
+  ::close(fd);
+  return 0;
+}
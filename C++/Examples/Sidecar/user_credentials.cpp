@@ -0,0 +1,18 @@
+#ifndef USER_CREDENTIALS
+#define USER_CREDENTIALS
+
+#include <iostream>
+/*
+ Test accounts:
+   username: githubtester1 ; password: gitHubTester1password ;
+   username: githubtester2 ; password: gitHubTester2password ;
+   username: githubtester3 ; password: gitHubTester3password ;
+ Replace the following string variables with the account that you want to use.
+*/
+
+std::string username = "githubtester1";
+std::string password = "gitHubTester1password";
+std::string tenant   = "cbe_githubtesters";
+std::string client   = "linux_desktop";
+
+#endif  // USER_CREDENTIALS
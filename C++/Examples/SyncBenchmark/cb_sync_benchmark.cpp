@@ -0,0 +1,162 @@
+/*
+  Copyright © CloudBackend AB 2025.
+*/
+
+/**
+ * Measures the per call latency of the different ways of making the same
+ * query: synchronous [exception], synchronous [non-throwing], asynchronous
+ * with a delegate class blocking on a condition variable, and
+ * cbe::util::callSync().
+ *
+ * usage: cb_sync_benchmark [iterations] [nocache]
+ */
+
+#include "cbe/Account.h"
+#include "cbe/CloudBackend.h"
+#include "cbe/Filter.h"
+#include "cbe/QueryChain.h"
+#include "cbe/QueryChainSync.h"
+#include "cbe/util/Sync.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "user_credentials.cpp"  // file is located in this folder
+
+// - - - - - - - - - - - - - - - - - DELEGATES - - - - - - - - - - - - - - - - -
+// The delegate pattern of the asynchronous examples
+class QueryDelegate : public cbe::delegate::QueryDelegate {
+  std::mutex              mutex{};
+  std::condition_variable conditionVariable{};
+  bool                    called = false;
+
+  void onQuerySuccess(cbe::QueryResult&& queryResult) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      this->queryResult = std::move(queryResult);
+      called = true;
+    }
+    conditionVariable.notify_one();
+  }
+  void onQueryError(cbe::delegate::QueryError&& error,
+                    cbe::util::Context&&        context) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      errorInfo = ErrorInfo{std::move(context), std::move(error)};
+      called = true;
+    }
+    conditionVariable.notify_one();
+  }
+public:
+  cbe::QueryResult  queryResult{cbe::DefaultCtor{}};
+  ErrorInfo         errorInfo{};
+
+  void waitForRsp() {
+    std::unique_lock<std::mutex> lock(mutex);
+    conditionVariable.wait(lock, [this] { return called; });
+  }
+}; // class QueryDelegate
+
+// - - - - - - - - - - - - - - - - - BENCHMARK - - - - - - - - - - - - - - - - -
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Runs \p call \p iterations times and prints the latency percentiles.
+ * \p call returns false on a failed query.
+ */
+bool measure(const std::string& name,
+             int                iterations,
+             std::function<bool()> call) {
+  std::vector<double> micros{};
+  micros.reserve(iterations);
+  for (int i = 0; i < iterations; ++i) {
+    const auto start = Clock::now();
+    if (!call()) {
+      std::cout << name << ": query failed" << std::endl;
+      return false;
+    }
+    micros.push_back(std::chrono::duration<double, std::micro>(
+                                                Clock::now() - start).count());
+  }
+  std::sort(micros.begin(), micros.end());
+  auto percentile = [&micros](double p) {
+    return micros[static_cast<std::size_t>(p * (micros.size() - 1))];
+  };
+  std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+            << std::setprecision(1)
+            << " p50=" << std::setw(10) << percentile(0.50) << " us"
+            << " p90=" << std::setw(10) << percentile(0.90) << " us"
+            << " p99=" << std::setw(10) << percentile(0.99) << " us"
+            << std::endl;
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+  const bool bypassCache = argc > 2 && std::string{argv[2]} == "nocache";
+
+  cbe::CloudBackend::LogInError logInError;
+  cbe::CloudBackend cloudBackend = cbe::CloudBackend::logIn(username,
+                                                            password,
+                                                            tenant,
+                                                            client,
+                                                            logInError);
+  if (logInError) {
+    std::cout << "Error, login failed! \nError info=" << logInError
+              << std::endl;
+    return 1;
+  }
+  const cbe::ContainerId rootId = cloudBackend.account().rootContainer().id();
+  auto filter = [bypassCache]() {
+    return cbe::Filter{}.setByPassCache(bypassCache);
+  };
+  std::cout << iterations << " queries per variant, cache "
+            << (bypassCache ? "bypassed" : "enabled") << std::endl;
+
+  // Warm up the connection and, unless bypassed, the cache
+  cbe::CloudBackend::QueryJoinError warmUpError;
+  cloudBackend.query(rootId, filter(), warmUpError);
+
+  bool ok = true;
+  ok = ok && measure("sync [exception]", iterations, [&]() {
+    try {
+      cloudBackend.query(rootId, filter()).getQueryResult();
+      return true;
+    } catch (const cbe::CloudBackend::QueryException& exception) {
+      std::cout << exception.what() << std::endl;
+      return false;
+    }
+  });
+  ok = ok && measure("sync [non-throwing]", iterations, [&]() {
+    cbe::CloudBackend::QueryJoinError error;
+    cloudBackend.query(rootId, filter(), error).getQueryResult();
+    return !error;
+  });
+  ok = ok && measure("async + condition variable", iterations, [&]() {
+    auto queryDelegate = std::make_shared<QueryDelegate>();
+    cloudBackend.query(rootId, filter(), queryDelegate);
+    queryDelegate->waitForRsp();
+    return !queryDelegate->errorInfo;
+  });
+  ok = ok && measure("cbe::util::callSync", iterations, [&]() {
+    cbe::delegate::QueryDelegate::ErrorInfo error;
+    auto result = cbe::util::callSync<cbe::delegate::QueryDelegate>(
+      [&](cbe::delegate::QueryDelegatePtr queryDelegate) {
+        cloudBackend.query(rootId, filter(), queryDelegate);
+      },
+      error);
+    return static_cast<bool>(result);
+  });
+
+  cloudBackend.terminate();
+  return ok ? 0 : 2;
+}
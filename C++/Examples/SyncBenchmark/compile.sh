@@ -0,0 +1,34 @@
+#!/usr/bin/sh
+# compile.sh
+# release 2025-03-03
+
+PARENTSCRIPT_PATH="$(dirname "$0")"
+cd ${PARENTSCRIPT_PATH}
+echo ${PWD}
+
+ARCH=`uname -m`
+echo "computer architechture ${ARCH}"
+case "${ARCH}" in
+    "x86_64")
+    COMPILER_COMMAND="g++ -std=c++17 -pthread -O2"
+    # libCBE=${HOME}"/cbe/current/C++/lib/Linux_x86/libcb_sdk.so"
+    libCBE=${HOME}"/cbe/current/C++/lib/Linux_x86/libcb_sdk.a"
+    WARNINGS="-Wpedantic -Wall -Wextra -Weffc++ -Wsuggest-override -Wno-unused-parameter"
+    CODE_PATH="./"
+    ;;
+
+    *)
+    uname -a
+    echo "platform not supported in this release"
+    exit 1
+    ;;
+esac
+
+echo "compile example code."
+${COMPILER_COMMAND} ${WARNINGS} -o "cb_sync_benchmark" "${CODE_PATH}cb_sync_benchmark.cpp" ${libCBE} -I "../../include" -ldl
+if [ $? -eq 0 ]
+then
+    echo "To run use: sh run.sh [iterations] [nocache]"
+else
+    echo "Error encountered."
+fi
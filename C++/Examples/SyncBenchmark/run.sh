@@ -0,0 +1,9 @@
+#!/usr/bin/sh
+# run.sh [iterations] [nocache]
+# release 2025-03-03
+
+echo "CloudBackend SDK is provided under a limited evaluation licence."
+echo "Not for production use."
+
+export LD_LIBRARY_PATH="../../lib/Linux_x86"
+./cb_sync_benchmark "$@"
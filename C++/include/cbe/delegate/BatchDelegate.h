@@ -0,0 +1,96 @@
+#ifndef CBE__delegate__BatchDelegate_h__
+#define CBE__delegate__BatchDelegate_h__
+
+#include "cbe/Item.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/Error.h"
+
+#include "cbe/util/Context.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cbe {
+  namespace delegate {
+
+/**
+ * @brief
+ * The outcome of the operation on one item of a batch.
+ */
+class BatchItemResult {
+public:
+  /** Id of the item the operation was applied on. */
+  cbe::ItemId         itemId{};
+  /**
+   * The item as returned by the operation, i.e., moved or renamed.
+   * Unreal for a removed item, or if the operation failed.
+   */
+  cbe::Item           item{cbe::DefaultCtor{}};
+  /**
+   * Error information of a failed operation. Evaluates to \c false if the
+   * operation succeeded.
+   */
+  delegate::Error     error{};
+  /** Context of the failed service call, if the operation failed. */
+  cbe::util::Context  context{};
+
+  /**
+   * @brief Checks if the operation on the item succeeded.
+   */
+  explicit operator bool() const { return !error; }
+}; // class BatchItemResult
+
+/**
+ * @brief Per item outcome of a batch, in the same order as the items passed in.
+ */
+using BatchResults = std::vector<BatchItemResult>;
+
+/**
+ * Delegate class for the asynchronous batch operations:
+ * <ul>
+ *   <li> cbe::util::moveItems()
+ *   <li> cbe::util::renameItems()
+ *   <li> cbe::util::removeItems()
+ * </ul>
+ */
+class BatchDelegate {
+public:
+  using Success = BatchResults;
+  /**
+   * Called once when the operation has completed for all items of the batch.
+   *
+   * A batch as such cannot fail, the outcome of each item is reported in
+   * \p results.
+   * @param results One entry per item, in the order the items were passed in.
+   */
+  virtual void onBatchCompleted(BatchResults&& results) = 0;
+
+  /**
+   * Called each time the operation on an item has completed.
+   *
+   * The default implementation ignores the event.
+   * @param index   Position of the item in the batch.
+   * @param result  Outcome for the item.
+   */
+  virtual void onBatchItemCompleted(std::size_t            /*index*/,
+                                    const BatchItemResult& /*result*/) {}
+
+  virtual ~BatchDelegate() = default;
+}; // class BatchDelegate
+
+/**
+ * Pointer to BatchDelegate that is passed into:
+ * <ul>
+ *   <li> cbe::util::moveItems()
+ *   <li> cbe::util::renameItems()
+ *   <li> cbe::util::removeItems()
+ * </ul>
+ */
+using BatchDelegatePtr = std::shared_ptr<BatchDelegate>;
+
+  } // namespace delegate
+} // namespace cbe
+
+#endif // !CBE__delegate__BatchDelegate_h__
@@ -0,0 +1,39 @@
+#ifndef CBE__delegate__BatchListenerDelegate_h__
+#define CBE__delegate__BatchListenerDelegate_h__
+
+#include "cbe/delegate/ChangeEvent.h"
+
+#include <memory>
+
+namespace cbe {
+  namespace delegate {
+
+/**
+ * Listener class receiving the remote changes in batches, see
+ * cbe::util::BatchListener.
+ */
+class BatchListenerDelegate {
+public:
+  /**
+   * Called with the changes received during one batching window.
+   *
+   * Calls are never concurrent, and are made in the order the batches were
+   * formed.
+   * @param events The changes, repeated changes of the same item coalesced
+   *               into one event unless disabled.
+   */
+  virtual void onRemoteChanges(ChangeEvents&& events) = 0;
+
+  virtual ~BatchListenerDelegate() = default;
+}; // class BatchListenerDelegate
+
+/**
+ * Pointer to BatchListenerDelegate that is passed into
+ * cbe::util::batchListener().
+ */
+using BatchListenerDelegatePtr = std::shared_ptr<BatchListenerDelegate>;
+
+  } // namespace delegate
+} // namespace cbe
+
+#endif // #ifndef CBE__delegate__BatchListenerDelegate_h__
@@ -0,0 +1,63 @@
+#ifndef CBE__delegate__ChangeEvent_h__
+#define CBE__delegate__ChangeEvent_h__
+
+#include "cbe/Item.h"
+#include "cbe/Types.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cbe {
+  namespace delegate {
+
+/**
+ * @brief
+ * One remote change, as reported to a CloudBackendListenerDelegate, in the
+ * form of a value.
+ *
+ * A change event may stand for several changes of the same item that have
+ * been coalesced, see cbe::util::BatchListener, hence the set of #kinds.
+ */
+class ChangeEvent {
+public:
+  /**
+   * Kinds of change, combined bitwise in #kinds.
+   */
+  enum Kind : std::uint8_t {
+    Added   = 1,
+    Moved   = 2,
+    Renamed = 4,
+    Removed = 8
+  };
+
+  /** Bitwise or of the Kind values of the change(s). */
+  std::uint8_t    kinds{};
+  /** cbe::ItemType::Object or cbe::ItemType::Container. */
+  cbe::ItemType   itemType{cbe::ItemType::Unknown};
+  /** Id of the changed item. */
+  cbe::ItemId     itemId{};
+  /** The latest name of the item. */
+  std::string     name{};
+  /**
+   * The latest state of the item, use cbe::CloudBackend::castObject() or
+   * cbe::CloudBackend::castContainer() to get at the derived type.
+   * Unreal if the item has been removed.
+   */
+  cbe::Item       item{cbe::DefaultCtor{}};
+
+  /**
+   * @brief Checks if the event includes a change of kind \p kind.
+   */
+  bool is(Kind kind) const { return (kinds & kind) != 0; }
+}; // class ChangeEvent
+
+/**
+ * @brief Change events, in the order the (first) changes were received.
+ */
+using ChangeEvents = std::vector<ChangeEvent>;
+
+  } // namespace delegate
+} // namespace cbe
+
+#endif // #ifndef CBE__delegate__ChangeEvent_h__
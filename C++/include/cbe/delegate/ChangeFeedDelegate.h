@@ -0,0 +1,82 @@
+#ifndef CBE__delegate__ChangeFeedDelegate_h__
+#define CBE__delegate__ChangeFeedDelegate_h__
+
+#include "cbe/delegate/ChangeEvent.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cbe {
+  namespace delegate {
+
+/**
+ * @brief A position in a cbe::util::ChangeFeed, to resume the feed from.
+ *
+ * Positions of one feed increase monotonically. A position of another feed,
+ * e.g., of the feed of a previous process, has another #epoch.
+ */
+class FeedPosition {
+public:
+  FeedPosition() = default;
+  FeedPosition(std::uint64_t epoch, std::uint64_t sequence)
+    : epoch{epoch}, sequence{sequence} {}
+
+  /** Identifies the feed instance. */
+  std::uint64_t epoch{};
+  /** Sequence number of the last event consumed, 0 if none. */
+  std::uint64_t sequence{};
+}; // class FeedPosition
+
+/**
+ * @brief A remote change and its position in the feed.
+ */
+class FeedEvent {
+public:
+  /** Position of the event, to be stored by the consumer to resume from. */
+  FeedPosition  position{};
+  ChangeEvent   event{};
+}; // class FeedEvent
+
+/**
+ * @brief Feed events in increasing order of position.
+ */
+using FeedEvents = std::vector<FeedEvent>;
+
+/**
+ * Delegate class of a subscription to a cbe::util::ChangeFeed.
+ */
+class ChangeFeedDelegate {
+public:
+  /**
+   * Called with the next events of the feed: first with all the missed events
+   * at once when resuming, thereafter as the changes are received.
+   *
+   * Calls are never concurrent.
+   * @param events Events whose positions follow directly on the previous ones.
+   */
+  virtual void onFeedEvents(FeedEvents&& events) = 0;
+
+  /**
+   * Called instead of replaying the missed events, if the position resumed
+   * from is no longer retained by the feed, or belongs to another feed.
+   *
+   * The consumer is to re-synchronize, e.g., by querying the containers of
+   * interest, and then continues with the events after \p resumedAt.
+   * @param resumedAt The current position of the feed.
+   */
+  virtual void onFeedGap(FeedPosition resumedAt) = 0;
+
+  virtual ~ChangeFeedDelegate() = default;
+}; // class ChangeFeedDelegate
+
+/**
+ * Pointer to ChangeFeedDelegate that is passed into
+ * cbe::util::ChangeFeed::subscribe().
+ */
+using ChangeFeedDelegatePtr = std::shared_ptr<ChangeFeedDelegate>;
+
+  } // namespace delegate
+} // namespace cbe
+
+#endif // #ifndef CBE__delegate__ChangeFeedDelegate_h__
@@ -0,0 +1,88 @@
+#ifndef CBE__delegate__LiveQueryDelegate_h__
+#define CBE__delegate__LiveQueryDelegate_h__
+
+#include "cbe/Item.h"
+#include "cbe/QueryResult.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/QueryError.h"
+
+#include "cbe/util/Context.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cbe {
+  namespace delegate {
+
+/**
+ * @brief One change of the item list of a cbe::util::LiveQuery.
+ *
+ * The positions of the diffs passed in one call are to be applied in order:
+ * each refers to the list as left by the previous diff.
+ */
+class ItemDiff {
+public:
+  enum Kind : std::uint8_t {
+    /** The item has been inserted at #to. */
+    Inserted,
+    /** The item at #from has been removed. */
+    Removed,
+    /**
+     * The item at #from has changed, and is now at #to, equal to #from if its
+     * position has not changed.
+     */
+    Changed
+  };
+
+  Kind          kind{Inserted};
+  cbe::ItemId   itemId{};
+  /** The latest state of the item, unreal if removed. */
+  cbe::Item     item{cbe::DefaultCtor{}};
+  /** Position before the change, Removed and Changed only. */
+  std::size_t   from{};
+  /** Position after the change, Inserted and Changed only. */
+  std::size_t   to{};
+}; // class ItemDiff
+
+using ItemDiffs = std::vector<ItemDiff>;
+
+/**
+ * Delegate class of a cbe::util::LiveQuery.
+ *
+ * Calls are never concurrent, and are made in the order of the changes.
+ */
+class LiveQueryDelegate {
+public:
+  /**
+   * Called once the query has returned, with its items in the order of the
+   * live query.
+   */
+  virtual void onLiveQueryLoaded(cbe::QueryResult::ItemsSnapshot&& items) = 0;
+
+  /**
+   * Called with the changes of the list since the previous call.
+   */
+  virtual void onLiveQueryDiffs(ItemDiffs&& diffs) = 0;
+
+  using Error = QueryError;
+  /**
+   * Called if the query fails; no further calls are made.
+   */
+  virtual void onLiveQueryError(QueryError&&          error,
+                                cbe::util::Context&&  context) = 0;
+
+  virtual ~LiveQueryDelegate() = default;
+}; // class LiveQueryDelegate
+
+/**
+ * Pointer to LiveQueryDelegate that is passed into cbe::util::LiveQuery.
+ */
+using LiveQueryDelegatePtr = std::shared_ptr<LiveQueryDelegate>;
+
+  } // namespace delegate
+} // namespace cbe
+
+#endif // #ifndef CBE__delegate__LiveQueryDelegate_h__
@@ -0,0 +1,90 @@
+#ifndef CBE__delegate__MakeDelegate_h__
+#define CBE__delegate__MakeDelegate_h__
+
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Cancellation.h"
+#include "cbe/util/Deadline.h"
+
+#include <memory>
+#include <utility>
+
+namespace cbe {
+  namespace delegate {
+
+/**
+ * @brief Creates a delegate from two callables, as an alternative to writing a
+ *        class implementing the delegate interface.
+ *
+ * The returned pointer is passed into the asynchronous call like any other
+ * delegate:
+ * \code {.cpp}
+ * container.createObject(
+ *   name, keyValues,
+ *   cbe::delegate::makeDelegate<cbe::delegate::CreateObjectDelegate>(
+ *     [](cbe::Object&& object) { ... },
+ *     [](cbe::delegate::Error&& error, cbe::util::Context&& context) { ... }));
+ * \endcode
+ *
+ * The callables are stored by value inside the delegate object, without type
+ * erasure, so the delegate costs the single allocation the asynchronous call
+ * requires anyway, and the callables may be move-only, e.g., capture a
+ * <code>std::unique_ptr</code> or a <code>std::promise</code>.
+ *
+ * Callbacks other than the success and error callbacks, e.g., the chunk
+ * progress of an upload or download, keep their default implementation.
+ *
+ * Should a default timeout be set, see cbe::util::setDefaultTimeout(), the
+ * delegate is created as by
+ * makeDelegate(const util::CancellationToken&,SuccessFnT&&,ErrorFnT&&) with
+ * a token expiring after the default timeout.
+ *
+ * @tparam DelegateT    Delegate interface of the asynchronous call, e.g.,
+ *                      QueryDelegate or UploadDelegate. All interfaces of
+ *                      the asynchronous calls are supported except
+ *                      AddMemberDelegate and RemoveMemberDelegate.
+ * @param successFn     Invoked as <code>successFn(DelegateT::Success&&)</code>,
+ *                      e.g., with a cbe::QueryResult for a QueryDelegate.
+ *                      Callbacks delivering several values are bundled into
+ *                      the \c Success type, e.g., DownloadBinarySuccess.
+ * @param errorFn       Invoked as
+ *                      <code>errorFn(DelegateT::Error&&, cbe::util::Context&&)</code>.
+ * @return Pointer to the delegate.
+ */
+template <class DelegateT, class SuccessFnT, class ErrorFnT>
+std::shared_ptr<DelegateT> makeDelegate(SuccessFnT&& successFn,
+                                        ErrorFnT&&   errorFn) {
+  auto token = util::impl::defaultDeadline();
+  if (token.canBeCancelled()) {
+    return util::impl::makeCancellableFnDelegate<DelegateT>(
+                                          token,
+                                          std::forward<SuccessFnT>(successFn),
+                                          std::forward<ErrorFnT>(errorFn));
+  }
+  return impl::makeFnDelegate<DelegateT>(std::forward<SuccessFnT>(successFn),
+                                         std::forward<ErrorFnT>(errorFn));
+}
+
+/**
+ * @brief Creates a cancellable delegate from two callables.
+ *
+ * Same as makeDelegate(SuccessFnT&&,ErrorFnT&&), except that cancelling
+ * \p token before the call completes invokes \p errorFn right away, on the
+ * cancelling thread, with error code cbe::util::cancelledErrorCode, and that
+ * the response of the call arriving afterwards is ignored.
+ * See cbe::util::CancellationSource.
+ */
+template <class DelegateT, class SuccessFnT, class ErrorFnT>
+std::shared_ptr<DelegateT> makeDelegate(const util::CancellationToken& token,
+                                        SuccessFnT&&                   successFn,
+                                        ErrorFnT&&                     errorFn) {
+  return util::impl::makeCancellableFnDelegate<DelegateT>(
+                                          token,
+                                          std::forward<SuccessFnT>(successFn),
+                                          std::forward<ErrorFnT>(errorFn));
+}
+
+  } // namespace delegate
+} // namespace cbe
+
+#endif // #ifndef CBE__delegate__MakeDelegate_h__
@@ -0,0 +1,121 @@
+#ifndef CBE__delegate__TransactionDelegate_h__
+#define CBE__delegate__TransactionDelegate_h__
+
+#include "cbe/Item.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/Error.h"
+
+#include "cbe/util/Context.h"
+#include "cbe/util/ErrorInfo.h"
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cbe {
+  namespace delegate {
+
+/**
+ * @brief
+ * Convenience type that bundles the result passed to method
+ * cbe::delegate::TransactionDelegate::onTransactionSuccess.
+ */
+class TransactionSuccess {
+public:
+  /**
+   * The resulting item of each mutation, in the order the mutations were added
+   * to the cbe::util::Transaction. I.e., the created, updated, moved or renamed
+   * item. Unreal for a removed item.
+   */
+  std::vector<cbe::Item> items{};
+}; // class TransactionSuccess
+
+/**
+ * Contains error information delivered in connection with a failed
+ * cbe::util::Transaction.
+ *
+ * errorCode 412 (Precondition Failed) implies that an item touched or
+ * expected by the transaction had been changed by someone else, in which case
+ * nothing has been applied.
+ */
+class TransactionError : public Error {
+public:
+  /**
+   * Index of the mutation that failed, in the order the mutations were added.
+   * Equals the number of mutations if the transaction failed before any
+   * mutation was attempted, e.g., due to a failed precondition.
+   */
+  std::size_t   failedIndex{};
+  /** Id of the item that caused the failure, if any. */
+  cbe::ItemId   itemId{};
+  /**
+   * \c true if all mutations applied before the failure have been compensated,
+   * \c false if one or more compensations failed, or if an item had already
+   * been removed, which cannot be undone.
+   */
+  bool          rolledBack{};
+
+  TransactionError() = default;
+  TransactionError(Error&&      error,
+                   std::size_t  failedIndex,
+                   cbe::ItemId  itemId,
+                   bool         rolledBack)
+    : Error{std::move(error)}, failedIndex{failedIndex}, itemId{itemId},
+      rolledBack{rolledBack} {}
+
+  friend std::ostream& operator<<(std::ostream&           os,
+                                  const TransactionError& error) {
+    return os << static_cast<const Error&>(error)
+              << " failedIndex=" << error.failedIndex
+              << " itemId=" << error.itemId
+              << " rolledBack=" << std::boolalpha << error.rolledBack;
+  }
+}; // class TransactionError
+
+/**
+ * Delegate class for the asynchronous version of method:
+ * <ul>
+ *   <li> cbe::util::Transaction::commit()
+ * </ul>
+ */
+class TransactionDelegate {
+public:
+  using Success = TransactionSuccess;
+  /**
+   * Called when all mutations of the transaction have been applied.
+   * @param success The resulting item of each mutation.
+   */
+  virtual void onTransactionSuccess(TransactionSuccess&& success) = 0;
+
+  using Error = TransactionError;
+  /**
+   * Called if the transaction failed, after the compensation of the mutations
+   * already applied has been attempted.
+   */
+  virtual void onTransactionError(TransactionError&&   error,
+                                  cbe::util::Context&& context) = 0;
+
+  /**
+   * Contains all information about a failed transaction.
+   */
+  struct ErrorInfo : cbe::util::ErrorInfoImpl<Error> {
+    using Base::Base; // Inherit base class' constructors
+  }; // struct ErrorInfo
+
+  virtual ~TransactionDelegate() = default;
+}; // class TransactionDelegate
+
+/**
+ * Pointer to TransactionDelegate that is passed into:
+ * cbe::util::Transaction::commit()
+ */
+using TransactionDelegatePtr = std::shared_ptr<TransactionDelegate>;
+
+  } // namespace delegate
+} // namespace cbe
+
+#endif // !CBE__delegate__TransactionDelegate_h__
@@ -0,0 +1,117 @@
+#ifndef CBE__delegate__container__SubtreeDelegate_h__
+#define CBE__delegate__container__SubtreeDelegate_h__
+
+#include "cbe/Container.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/Error.h"
+
+#include "cbe/util/Context.h"
+#include "cbe/util/ErrorInfo.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace cbe {
+  namespace delegate {
+    namespace container {
+
+/**
+ * @brief
+ * Progress counters of a running subtree job, passed to
+ * SubtreeDelegate::onSubtreeProgress().
+ *
+ * The \c ...Found counters grow as the job discovers the subtree, hence they
+ * are only final once the job has completed.
+ */
+class SubtreeProgress {
+public:
+  /** Number of containers discovered so far. */
+  std::uint64_t containersFound{};
+  /** Number of containers processed so far. */
+  std::uint64_t containersDone{};
+  /** Number of objects discovered so far. */
+  std::uint64_t objectsFound{};
+  /** Number of objects processed so far. */
+  std::uint64_t objectsDone{};
+  /** Number of bytes of object data transferred so far. */
+  std::uint64_t bytesDone{};
+}; // class SubtreeProgress
+
+/**
+ * @brief
+ * Convenience type that bundles the result passed to method
+ * cbe::delegate::container::SubtreeDelegate::onSubtreeSuccess.
+ */
+class SubtreeSuccess {
+public:
+  /**
+   * The root of the resulting subtree, i.e., the new container in case of
+   * cbe::util::copySubtree(). Unreal for cbe::util::removeSubtree().
+   */
+  cbe::Container    container{cbe::DefaultCtor{}};
+  /** Id of the root of the processed subtree. */
+  cbe::ContainerId  containerId{};
+  /** Name of the root of the processed subtree. */
+  std::string       name{};
+  /** Final counters of the job. */
+  SubtreeProgress   progress{};
+}; // class SubtreeSuccess
+
+/**
+ * Delegate class for the subtree jobs:
+ * <ul>
+ *   <li> cbe::util::copySubtree()
+ *   <li> cbe::util::removeSubtree()
+ * </ul>
+ */
+class SubtreeDelegate {
+public:
+  using Success = SubtreeSuccess;
+  /**
+   * Called once when the whole subtree has been processed.
+   * @param success Root and final counters of the job.
+   */
+  virtual void onSubtreeSuccess(SubtreeSuccess&& success) = 0;
+
+  using Error = delegate::Error;
+  /**
+   * Called once if the job fails. No further requests are issued after a
+   * failure, and the callback is made first after all requests in flight have
+   * completed.
+   */
+  virtual void onSubtreeError(Error&& error, cbe::util::Context&& context) = 0;
+
+  /**
+   * Called each time an item of the subtree has been processed.
+   *
+   * The default implementation ignores the progress.
+   * @param progress Counters of the job so far.
+   */
+  virtual void onSubtreeProgress(const SubtreeProgress& /*progress*/) {}
+
+  /**
+   * Contains all information about a failed subtree job.
+   */
+  struct ErrorInfo : cbe::util::ErrorInfoImpl<Error> {
+    using Base::Base; // Inherit base class' constructors
+  }; // struct ErrorInfo
+
+  virtual ~SubtreeDelegate() = default;
+}; // class SubtreeDelegate
+
+/**
+ * Pointer to SubtreeDelegate that is passed into:
+ * <ul>
+ *   <li> cbe::util::copySubtree()
+ *   <li> cbe::util::removeSubtree()
+ * </ul>
+ */
+using SubtreeDelegatePtr = std::shared_ptr<SubtreeDelegate>;
+
+    } // namespace container
+  } // namespace delegate
+} // namespace cbe
+
+#endif // !CBE__delegate__container__SubtreeDelegate_h__
@@ -0,0 +1,755 @@
+#ifndef CBE__delegate__impl__FnDelegate_h__
+#define CBE__delegate__impl__FnDelegate_h__
+
+#include "cbe/CloudBackend.h"
+#include "cbe/Container.h"
+#include "cbe/Group.h"
+#include "cbe/GroupQueryResult.h"
+#include "cbe/Member.h"
+#include "cbe/Object.h"
+#include "cbe/QueryResult.h"
+#include "cbe/Role.h"
+#include "cbe/Stream.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/AclDelegate.h"
+#include "cbe/delegate/AddRoleMemberDelegate.h"
+#include "cbe/delegate/BanDelegate.h"
+#include "cbe/delegate/CreateAccountDelegate.h"
+#include "cbe/delegate/CreateContainerDelegate.h"
+#include "cbe/delegate/CreateGroupDelegate.h"
+#include "cbe/delegate/CreateObjectDelegate.h"
+#include "cbe/delegate/CreateRoleDelegate.h"
+#include "cbe/delegate/DownloadBinaryDelegate.h"
+#include "cbe/delegate/DownloadBinarySuccess.h"
+#include "cbe/delegate/DownloadDelegate.h"
+#include "cbe/delegate/DownloadSuccess.h"
+#include "cbe/delegate/GetStreamsDelegate.h"
+#include "cbe/delegate/GetSubscriptionsDelegate.h"
+#include "cbe/delegate/JoinDelegate.h"
+#include "cbe/delegate/KickDelegate.h"
+#include "cbe/delegate/LeaveDelegate.h"
+#include "cbe/delegate/ListGroupsDelegate.h"
+#include "cbe/delegate/ListMembersDelegate.h"
+#include "cbe/delegate/ListRolesDelegate.h"
+#include "cbe/delegate/ListSharesDelegate.h"
+#include "cbe/delegate/LogInDelegate.h"
+#include "cbe/delegate/PublishDelegate.h"
+#include "cbe/delegate/PublishSuccess.h"
+#include "cbe/delegate/QueryDelegate.h"
+#include "cbe/delegate/QueryJoinDelegate.h"
+#include "cbe/delegate/RemoveRoleDelegate.h"
+#include "cbe/delegate/RemoveRoleMemberDelegate.h"
+#include "cbe/delegate/SearchGroupsDelegate.h"
+#include "cbe/delegate/ShareDelegate.h"
+#include "cbe/delegate/SubscribeDelegate.h"
+#include "cbe/delegate/UnBanDelegate.h"
+#include "cbe/delegate/UnPublishDelegate.h"
+#include "cbe/delegate/UnShareDelegate.h"
+#include "cbe/delegate/UnSubscribeDelegate.h"
+#include "cbe/delegate/UpdateKeyValuesDelegate.h"
+#include "cbe/delegate/UploadDelegate.h"
+#include "cbe/delegate/container/MoveDelegate.h"
+#include "cbe/delegate/container/RemoveDelegate.h"
+#include "cbe/delegate/container/RenameDelegate.h"
+#include "cbe/delegate/group/JoinDelegate.h"
+#include "cbe/delegate/group/RemoveDelegate.h"
+#include "cbe/delegate/group/RenameDelegate.h"
+#include "cbe/delegate/group/RenameSuccess.h"
+#include "cbe/delegate/object/MoveDelegate.h"
+#include "cbe/delegate/object/RemoveDelegate.h"
+#include "cbe/delegate/object/RenameDelegate.h"
+
+#include "cbe/util/Context.h"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace cbe {
+  namespace delegate {
+    namespace impl {
+
+/**
+ * @brief Holds the two callables that an FnDelegate forwards to.
+ *
+ * \p SuccessFnT is invoked as <code>successFn(DelegateT::Success&&)</code> and
+ * \p ErrorFnT as <code>errorFn(DelegateT::Error&&, cbe::util::Context&&)</code>.
+ * The callables are stored by value inside the delegate object, hence a
+ * delegate created with makeFnDelegate() costs a single allocation.
+ */
+template <class DelegateT, class SuccessFnT, class ErrorFnT>
+class FnDelegateBase : public DelegateT {
+public:
+  FnDelegateBase(SuccessFnT successFn, ErrorFnT errorFn)
+    : successFn{std::move(successFn)}, errorFn{std::move(errorFn)} {}
+protected:
+  void succeed(typename DelegateT::Success&& success) {
+    successFn(std::move(success));
+  }
+  void fail(typename DelegateT::Error&& error, cbe::util::Context&& context) {
+    errorFn(std::move(error), std::move(context));
+  }
+private:
+  SuccessFnT successFn;
+  ErrorFnT   errorFn;
+}; // class FnDelegateBase
+
+/**
+ * @brief Delegate implementation that forwards the success and error callbacks
+ *        of \p DelegateT to callables.
+ *
+ * Specialized below for each delegate interface of the asynchronous calls,
+ * except AddMemberDelegate and RemoveMemberDelegate whose \c Success type
+ * carries more than their success callback delivers, and the interfaces not
+ * taken by any call of the SDK, e.g., CreateDelegate.
+ */
+template <class DelegateT, class SuccessFnT, class ErrorFnT>
+class FnDelegate;
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<QueryDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<QueryDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<QueryDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onQuerySuccess(cbe::QueryResult&& queryResult) override {
+    this->succeed(std::move(queryResult));
+  }
+  void onQueryError(QueryError&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<QueryDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<CreateContainerDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<CreateContainerDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<CreateContainerDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onCreateContainerSuccess(cbe::Container&& container) override {
+    this->succeed(std::move(container));
+  }
+  void onCreateContainerError(Error&&              error,
+                              cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<CreateContainerDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<CreateObjectDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<CreateObjectDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<CreateObjectDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onCreateObjectSuccess(cbe::Object&& object) override {
+    this->succeed(std::move(object));
+  }
+  void onCreateObjectError(Error&&              error,
+                           cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<CreateObjectDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<UploadDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<UploadDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<UploadDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onUploadSuccess(cbe::Object&& object) override {
+    this->succeed(std::move(object));
+  }
+  void onUploadError(TransferError&&      transferError,
+                     cbe::util::Context&& context) override {
+    this->fail(std::move(transferError), std::move(context));
+  }
+}; // class FnDelegate<UploadDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<DownloadBinaryDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<DownloadBinaryDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<DownloadBinaryDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onDownloadBinarySuccess(cbe::Object&&           object,
+                               std::unique_ptr<char[]> data) override {
+    this->succeed(DownloadBinarySuccess{std::move(object), std::move(data)});
+  }
+  void onDownloadBinaryError(TransferError&&      transferError,
+                             cbe::util::Context&& context) override {
+    this->fail(std::move(transferError), std::move(context));
+  }
+}; // class FnDelegate<DownloadBinaryDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<UpdateKeyValuesDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<UpdateKeyValuesDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<UpdateKeyValuesDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onUpdateKeyValuesSuccess(cbe::Object&& object) override {
+    this->succeed(std::move(object));
+  }
+  void onUpdateKeyValuesError(Error&&              error,
+                              cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<UpdateKeyValuesDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<container::RemoveDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<container::RemoveDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<container::RemoveDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onRemoveSuccess(cbe::ItemId containerId, std::string name) override {
+    this->succeed(container::RemoveSuccess{containerId, std::move(name)});
+  }
+  void onRemoveError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<container::RemoveDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<container::MoveDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<container::MoveDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<container::MoveDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onMoveSuccess(cbe::Container&& container) override {
+    this->succeed(std::move(container));
+  }
+  void onMoveError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<container::MoveDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<container::RenameDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<container::RenameDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<container::RenameDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onRenameSuccess(cbe::Container&& container) override {
+    this->succeed(std::move(container));
+  }
+  void onRenameError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<container::RenameDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<object::MoveDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<object::MoveDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<object::MoveDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onMoveSuccess(cbe::Object&& object) override {
+    this->succeed(std::move(object));
+  }
+  void onMoveError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<object::MoveDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<object::RenameDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<object::RenameDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<object::RenameDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onRenameSuccess(cbe::Object&& object) override {
+    this->succeed(std::move(object));
+  }
+  void onRenameError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<object::RenameDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<object::RemoveDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<object::RemoveDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<object::RemoveDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onRemoveSuccess(cbe::ItemId objectId, std::string name) override {
+    this->succeed(object::RemoveSuccess{objectId, std::move(name)});
+  }
+  void onRemoveError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<object::RemoveDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<DownloadDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<DownloadDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<DownloadDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onDownloadSuccess(cbe::Object&& object, std::string path) override {
+    this->succeed(DownloadSuccess{std::move(object), std::move(path)});
+  }
+  void onDownloadError(TransferError&&      transferError,
+                       cbe::util::Context&& context) override {
+    this->fail(std::move(transferError), std::move(context));
+  }
+}; // class FnDelegate<DownloadDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<JoinDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<JoinDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<JoinDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onJoinSuccess(cbe::QueryResult&& queryResult) override {
+    this->succeed(std::move(queryResult));
+  }
+  void onJoinError(JoinDelegate::JoinError&& error,
+                   cbe::util::Context&&      context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<JoinDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<QueryJoinDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<QueryJoinDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<QueryJoinDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onQueryJoinSuccess(cbe::QueryResult&& queryResult) override {
+    this->succeed(std::move(queryResult));
+  }
+  void onQueryJoinError(QueryJoinDelegate::QueryJoinError&& error,
+                        cbe::util::Context&&                context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<QueryJoinDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<CreateGroupDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<CreateGroupDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<CreateGroupDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onCreateGroupSuccess(cbe::Group&& group) override {
+    this->succeed(std::move(group));
+  }
+  void onCreateGroupError(Error&&              error,
+                          cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<CreateGroupDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<group::JoinDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<group::JoinDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<group::JoinDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onJoinSuccess(cbe::Group&& group) override {
+    this->succeed(std::move(group));
+  }
+  void onJoinError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<group::JoinDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<LeaveDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<LeaveDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<LeaveDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onLeaveSuccess(std::string&& memberName,
+                      cbe::MemberId memberId) override {
+    this->succeed(LeaveSuccess{std::move(memberName), memberId});
+  }
+  void onLeaveError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<LeaveDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<ListGroupsDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<ListGroupsDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<ListGroupsDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onListGroupsSuccess(ListGroupsDelegate::Groups&& groups) override {
+    this->succeed(std::move(groups));
+  }
+  void onListGroupsError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<ListGroupsDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<ListMembersDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<ListMembersDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<ListMembersDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onListMembersSuccess(ListMembersDelegate::Members&& members) override {
+    this->succeed(std::move(members));
+  }
+  void onListMembersError(Error&&              error,
+                          cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<ListMembersDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<SearchGroupsDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<SearchGroupsDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<SearchGroupsDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onSearchGroupsSuccess(cbe::GroupQueryResult&& queryResult) override {
+    this->succeed(std::move(queryResult));
+  }
+  void onSearchGroupsError(Error&&              error,
+                           cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<SearchGroupsDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<ShareDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<ShareDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<ShareDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onShareSuccess(cbe::ShareId shareId) override {
+    this->succeed(ShareSuccess{shareId});
+  }
+  void onShareError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<ShareDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<UnShareDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<UnShareDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<UnShareDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onUnShareSuccess(std::string&& message) override {
+    this->succeed(UnShareSuccess{std::move(message)});
+  }
+  void onUnShareError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<UnShareDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<ListSharesDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<ListSharesDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<ListSharesDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onListSharesSuccess(cbe::QueryResult&& queryResult) override {
+    this->succeed(std::move(queryResult));
+  }
+  void onListSharesError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<ListSharesDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<AclDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<AclDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<AclDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onAclSuccess(cbe::AclMap&& aclMap) override {
+    this->succeed(std::move(aclMap));
+  }
+  void onAclError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<AclDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<AddRoleMemberDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<AddRoleMemberDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<AddRoleMemberDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onAddRoleMemberSuccess(cbe::MemberId memberId) override {
+    this->succeed(std::move(memberId));
+  }
+  void onAddRoleMemberError(Error&&              error,
+                            cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<AddRoleMemberDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<BanDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<BanDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<BanDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onBanSuccess(std::string&& memberName, cbe::MemberId memberId) override {
+    this->succeed(BanSuccess{std::move(memberName), memberId});
+  }
+  void onBanError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<BanDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<CreateAccountDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<CreateAccountDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<CreateAccountDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onCreateAccountSuccess(cbe::UserId&& userId) override {
+    this->succeed(std::move(userId));
+  }
+  void onCreateAccountError(Error&&              error,
+                            cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<CreateAccountDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<CreateRoleDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<CreateRoleDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<CreateRoleDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onCreateRoleSuccess(cbe::Role&& role) override {
+    this->succeed(std::move(role));
+  }
+  void onCreateRoleError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<CreateRoleDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<GetStreamsDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<GetStreamsDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<GetStreamsDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onGetStreamsSuccess(cbe::Streams&& streams) override {
+    this->succeed(std::move(streams));
+  }
+  void onGetStreamsError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<GetStreamsDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<GetSubscriptionsDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<GetSubscriptionsDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<GetSubscriptionsDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onGetSubscriptionsSuccess(cbe::QueryResult&& queryResult) override {
+    this->succeed(std::move(queryResult));
+  }
+  void onGetSubscriptionsError(Error&&              error,
+                               cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<GetSubscriptionsDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<KickDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<KickDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<KickDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onKickSuccess(std::string&& memberName,
+                     cbe::MemberId memberId) override {
+    this->succeed(KickSuccess{std::move(memberName), memberId});
+  }
+  void onKickError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<KickDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<ListRolesDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<ListRolesDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<ListRolesDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onListRolesSuccess(ListRolesDelegate::Roles&& roles) override {
+    this->succeed(std::move(roles));
+  }
+  void onListRolesError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<ListRolesDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<LogInDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<LogInDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<LogInDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onLogInSuccess(cbe::CloudBackend&& cloudBackend) override {
+    this->succeed(std::move(cloudBackend));
+  }
+  void onLogInError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<LogInDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<PublishDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<PublishDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<PublishDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onPublishSuccess(cbe::Items&& items) override {
+    this->succeed(PublishSuccess{std::move(items)});
+  }
+  void onPublishError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<PublishDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<RemoveRoleDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<RemoveRoleDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<RemoveRoleDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onRemoveRoleSuccess(cbe::RoleId&& roleId) override {
+    this->succeed(std::move(roleId));
+  }
+  void onRemoveRoleError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<RemoveRoleDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<RemoveRoleMemberDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<RemoveRoleMemberDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<RemoveRoleMemberDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onRemoveRoleMemberSuccess(cbe::MemberId memberId) override {
+    this->succeed(std::move(memberId));
+  }
+  void onRemoveRoleMemberError(Error&&              error,
+                               cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<RemoveRoleMemberDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<SubscribeDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<SubscribeDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<SubscribeDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onSubscribeSuccess(cbe::Items&& items) override {
+    this->succeed(std::move(items));
+  }
+  void onSubscribeError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<SubscribeDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<UnBanDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<UnBanDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<UnBanDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onUnBanSuccess(std::string&& memberName,
+                      cbe::MemberId memberId) override {
+    this->succeed(UnBanSuccess{std::move(memberName), memberId});
+  }
+  void onUnBanError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<UnBanDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<UnPublishDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<UnPublishDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<UnPublishDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onUnPublishSuccess(cbe::PublishId publishId,
+                          cbe::ItemId    itemId) override {
+    this->succeed(UnPublishSuccess{publishId, itemId});
+  }
+  void onUnPublishError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<UnPublishDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<UnSubscribeDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<UnSubscribeDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<UnSubscribeDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onUnSubscribeSuccess(cbe::PublishId publishId,
+                            cbe::ItemId    itemId) override {
+    this->succeed(UnSubscribeSuccess{publishId, itemId});
+  }
+  void onUnSubscribeError(Error&&              error,
+                          cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<UnSubscribeDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<group::RemoveDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<group::RemoveDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<group::RemoveDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onRemoveSuccess(cbe::GroupId groupId, std::string&& groupName) override {
+    this->succeed(group::RemoveSuccess{groupId, std::move(groupName)});
+  }
+  void onRemoveError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<group::RemoveDelegate>
+
+template <class SuccessFnT, class ErrorFnT>
+class FnDelegate<group::RenameDelegate, SuccessFnT, ErrorFnT> final
+    : public FnDelegateBase<group::RenameDelegate, SuccessFnT, ErrorFnT> {
+  using Base = FnDelegateBase<group::RenameDelegate, SuccessFnT, ErrorFnT>;
+public:
+  using Base::Base;
+  void onRenameSuccess(cbe::Group&& group, std::string&& newName) override {
+    this->succeed(group::RenameSuccess{std::move(group), std::move(newName)});
+  }
+  void onRenameError(Error&& error, cbe::util::Context&& context) override {
+    this->fail(std::move(error), std::move(context));
+  }
+}; // class FnDelegate<group::RenameDelegate>
+
+/**
+ * @brief Creates a delegate of interface type \p DelegateT whose callbacks are
+ *        forwarded to \p successFn and \p errorFn.
+ *
+ * @return Pointer to the delegate, ready to be passed into the asynchronous
+ *         service call that expects a <code>std::shared_ptr<DelegateT></code>.
+ */
+template <class DelegateT, class SuccessFnT, class ErrorFnT>
+std::shared_ptr<DelegateT> makeFnDelegate(SuccessFnT&& successFn,
+                                          ErrorFnT&&   errorFn) {
+  using FnDelegateT = FnDelegate<DelegateT,
+                                 typename std::decay<SuccessFnT>::type,
+                                 typename std::decay<ErrorFnT>::type>;
+  return std::make_shared<FnDelegateT>(std::forward<SuccessFnT>(successFn),
+                                       std::forward<ErrorFnT>(errorFn));
+}
+
+    } // namespace impl
+  } // namespace delegate
+} // namespace cbe
+
+#endif // #ifndef CBE__delegate__impl__FnDelegate_h__
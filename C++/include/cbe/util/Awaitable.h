@@ -0,0 +1,215 @@
+#ifndef CBE__util__Awaitable_h__
+#define CBE__util__Awaitable_h__
+
+/**
+ * @file
+ * C++20 coroutine support: the asynchronous calls become awaitable, resuming
+ * the awaiting coroutine on completion instead of blocking a thread.
+ * Empty unless compiled with coroutine support, e.g., <code>-std=c++20</code>.
+ */
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Cancellation.h"
+#include "cbe/util/Context.h"
+#include "cbe/util/Deadline.h"
+#include "cbe/util/Executor.h"
+#include "cbe/util/Optional.h"
+
+#include <atomic>
+#include <coroutine>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Awaitable that starts an asynchronous call when awaited, and resumes
+ *        the awaiting coroutine when the call's delegate is called back.
+ *
+ * Created with awaitable(). Awaiting it yields, just like the synchronous
+ * non-throwing calls, a cbe::util::Optional of \p DelegateT::Success that is
+ * empty on failure, in which case the error information has been stored into
+ * the \p error parameter passed into awaitable().
+ *
+ * @tparam DelegateT  Delegate interface of the asynchronous call, any of the
+ *                    interfaces supported by cbe::delegate::impl::FnDelegate.
+ * @tparam StartFnT   Callable invoked as
+ *                    <code>start(std::shared_ptr<DelegateT>)</code> that makes
+ *                    the asynchronous call.
+ */
+template <class DelegateT, class StartFnT>
+class Awaitable {
+public:
+  using Success = typename DelegateT::Success;
+  using Error = typename DelegateT::Error;
+  using ErrorInfo = typename DelegateT::ErrorInfo;
+
+  Awaitable(StartFnT          start,
+            ErrorInfo&        error,
+            ExecutorPtr       executor,
+            CancellationToken token)
+    : start{std::move(start)}, error{error}, executor{std::move(executor)},
+      token{std::move(token)} {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    if (token.isCancelled()) {
+      error = ErrorInfo{cbe::util::Context{},
+                        impl::ErrorAs<Error>::make(token.error())};
+      return false;
+    }
+    // The coroutine is resumed once both the delegate has been called back
+    // and start() has returned, so that start() may refer to the locals of
+    // the coroutine even if cancelled meanwhile. The coroutine, and thereby
+    // this awaitable, may then be destroyed, hence nothing is accessed
+    // through this after the last resume().
+    auto start = std::move(this->start);
+    auto pending = std::make_shared<std::atomic<int>>(2);
+    auto resume = [executor = executor, handle, pending]() {
+      if (--*pending) {
+        return;
+      }
+      if (executor) {
+        executor->post([handle]() { handle.resume(); });
+      } else {
+        handle.resume();
+      }
+    };
+    auto onSuccess = [this, resume](Success&& success) {
+      result = std::move(success);
+      resume();
+    };
+    auto onError = [this, resume](Error&& error, cbe::util::Context&& context) {
+      this->error = ErrorInfo{std::move(context), std::move(error)};
+      resume();
+    };
+    if (token.canBeCancelled()) {
+      // Completed right away if cancelled since checked above
+      auto delegate = impl::makeCancellableFnDelegate<DelegateT>(
+                                                        token,
+                                                        std::move(onSuccess),
+                                                        std::move(onError));
+      if (!token.isCancelled()) {
+        start(std::move(delegate));
+      }
+    } else {
+      start(delegate::impl::makeFnDelegate<DelegateT>(std::move(onSuccess),
+                                                      std::move(onError)));
+    }
+    resume();
+    return true;
+  }
+
+  cbe::util::Optional<Success> await_resume() { return std::move(result); }
+
+private:
+  StartFnT                      start;
+  ErrorInfo&                    error;
+  ExecutorPtr                   executor;
+  CancellationToken             token;
+  cbe::util::Optional<Success>  result{};
+}; // class Awaitable
+
+/**
+ * @brief Makes an asynchronous call awaitable from a C++20 coroutine.
+ *
+ * The coroutine is resumed on the SDK thread that delivers the callback; use
+ * awaitable(StartFnT&&,typename DelegateT::ErrorInfo&,ExecutorPtr) to resume
+ * it elsewhere. Should a default timeout be set, see setDefaultTimeout(), the
+ * timeout starts when the awaitable is created.
+ *
+ * \par Example
+ * \code {.cpp}
+ * cbe::util::Optional<cbe::QueryResult> result{};
+ * cbe::delegate::QueryDelegate::ErrorInfo error{};
+ * result = co_await cbe::util::awaitable<cbe::delegate::QueryDelegate>(
+ *                   [&](auto delegate) { container.query(filter, delegate); },
+ *                   error);
+ * if (!result) {
+ *   std::cerr << error;
+ *   co_return;
+ * }
+ * cbe::delegate::DownloadDelegate::ErrorInfo downloadError{};
+ * auto download = co_await cbe::util::awaitable<cbe::delegate::DownloadDelegate>(
+ *                   [&](auto delegate) { object.download(path, delegate); },
+ *                   downloadError);
+ * \endcode
+ *
+ * @tparam DelegateT  Delegate interface of the asynchronous call.
+ * @param start       Invoked with a <code>std::shared_ptr<DelegateT></code>
+ *                    when the awaitable is awaited, and expected to make the
+ *                    asynchronous call with it.
+ * @param error       Out/return parameter receiving the error information
+ *                    should the call fail.
+ */
+template <class DelegateT, class StartFnT>
+Awaitable<DelegateT, typename std::decay<StartFnT>::type> awaitable(
+                                  StartFnT&&                       start,
+                                  typename DelegateT::ErrorInfo&   error) {
+  return {std::forward<StartFnT>(start), error, nullptr,
+          impl::defaultDeadline()};
+}
+
+/**
+ * @brief Makes an asynchronous call awaitable from a C++20 coroutine, resuming
+ *        the coroutine on \p executor.
+ *
+ * Resuming on an executor keeps the code following the <code>co_await</code>
+ * off the SDK thread.
+ * See awaitable(StartFnT&&,typename DelegateT::ErrorInfo&).
+ */
+template <class DelegateT, class StartFnT>
+Awaitable<DelegateT, typename std::decay<StartFnT>::type> awaitable(
+                                  StartFnT&&                       start,
+                                  typename DelegateT::ErrorInfo&   error,
+                                  ExecutorPtr                      executor) {
+  return {std::forward<StartFnT>(start), error, std::move(executor),
+          impl::defaultDeadline()};
+}
+
+/**
+ * @brief Makes an asynchronous call awaitable from a C++20 coroutine, and
+ *        cancellable through \p token.
+ *
+ * Cancelling \p token resumes the coroutine right away, on the cancelling
+ * thread, or once the call has been started, with error code
+ * cbe::util::cancelledErrorCode, and the call is not started at all should
+ * \p token already be cancelled.
+ * See awaitable(StartFnT&&,typename DelegateT::ErrorInfo&).
+ */
+template <class DelegateT, class StartFnT>
+Awaitable<DelegateT, typename std::decay<StartFnT>::type> awaitable(
+                                  StartFnT&&                       start,
+                                  const CancellationToken&         token,
+                                  typename DelegateT::ErrorInfo&   error) {
+  return {std::forward<StartFnT>(start), error, nullptr, token};
+}
+
+/**
+ * @brief Makes an asynchronous call awaitable from a C++20 coroutine,
+ *        cancellable through \p token, and resuming the coroutine on
+ *        \p executor.
+ *
+ * See awaitable(StartFnT&&,const CancellationToken&,typename DelegateT::ErrorInfo&).
+ */
+template <class DelegateT, class StartFnT>
+Awaitable<DelegateT, typename std::decay<StartFnT>::type> awaitable(
+                                  StartFnT&&                       start,
+                                  const CancellationToken&         token,
+                                  typename DelegateT::ErrorInfo&   error,
+                                  ExecutorPtr                      executor) {
+  return {std::forward<StartFnT>(start), error, std::move(executor), token};
+}
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#endif // #ifndef CBE__util__Awaitable_h__
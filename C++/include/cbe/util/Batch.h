@@ -0,0 +1,455 @@
+#ifndef CBE__util__Batch_h__
+#define CBE__util__Batch_h__
+
+#include "cbe/CloudBackend.h"
+#include "cbe/Container.h"
+#include "cbe/Item.h"
+#include "cbe/Object.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/BatchDelegate.h"
+#include "cbe/delegate/Error.h"
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Cancellation.h"
+#include "cbe/util/Context.h"
+#include "cbe/util/impl/AsyncWindow.h"
+#include "cbe/util/impl/SyncSignal.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Tuning of the batch operations moveItems(), renameItems() and
+ *        removeItems().
+ */
+struct BatchOptions {
+  /**
+   * Maximum number of service calls kept in flight at the same time.
+   * The calls of a batch are pipelined, so the wall clock time of a batch is
+   * governed by this number rather than by the round-trip time per item.
+   */
+  std::size_t maxInFlight = 32;
+  /**
+   * Cancels the batch: the items whose operation has not been started yet are
+   * reported as failed with error code cbe::util::cancelledErrorCode, and the
+   * batch completes as soon as the calls in flight have returned.
+   */
+  CancellationToken cancellation{};
+}; // struct BatchOptions
+
+/**
+ * @brief Items paired with their new names, passed into renameItems().
+ */
+using ItemRenames = std::vector<std::pair<cbe::Item, std::string>>;
+
+    namespace impl {
+
+class BatchJob : public std::enable_shared_from_this<BatchJob> {
+public:
+  using Error = delegate::Error;
+  // Applies the operation on the item at the given index, and reports back
+  // through done() or failed()
+  using Operation = std::function<void(BatchJob&, std::size_t)>;
+
+  BatchJob(std::size_t                size,
+           delegate::BatchDelegatePtr delegate,
+           const BatchOptions&        options)
+    : delegate{std::move(delegate)}, options{options}, results(size),
+      started(size) {}
+
+  BatchJob(const BatchJob&) = delete;
+  BatchJob& operator=(const BatchJob&) = delete;
+
+  void start(Operation operation) {
+    auto self = shared_from_this();
+    // Kept by the job until finish(), which may run within complete() below
+    auto window = std::make_shared<AsyncWindow>(options.maxInFlight,
+                                                [self]() { self->finish(); });
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      this->window = window;
+    }
+    // Holds a slot until all the operations are posted, lest an operation
+    // completing inline drains the window early
+    window->post([]() {});
+    for (std::size_t index = 0; index < results.size(); ++index) {
+      window->post([self, operation, index]() {
+        {
+          std::lock_guard<std::mutex> lock{self->mutex};
+          self->started[index] = true;
+        }
+        operation(*self, index);
+      });
+    }
+    window->complete();
+    std::weak_ptr<BatchJob> weakSelf = self;
+    auto registration = options.cancellation.onCancel([weakSelf]() {
+      if (auto self = weakSelf.lock()) {
+        self->cancel();
+      }
+    });
+    std::lock_guard<std::mutex> lock{mutex};
+    if (this->window) {
+      cancellation = std::move(registration);
+    }
+  }
+
+  std::shared_ptr<BatchJob> share() { return shared_from_this(); }
+
+  void done(std::size_t index, cbe::Item item) {
+    BatchItemResultRef result{*this, index};
+    result->item = std::move(item);
+    result.complete();
+  }
+
+  void failed(std::size_t index, Error&& error, cbe::util::Context&& context) {
+    BatchItemResultRef result{*this, index};
+    result->error = std::move(error);
+    result->context = std::move(context);
+    result.complete();
+  }
+
+  void setItemId(std::size_t index, cbe::ItemId itemId) {
+    std::lock_guard<std::mutex> lock{mutex};
+    results[index].itemId = itemId;
+  }
+
+private:
+  // Gives locked access to one result, and reports it once filled in
+  class BatchItemResultRef {
+  public:
+    BatchItemResultRef(BatchJob& job, std::size_t index)
+      : job{job}, index{index}, lock{job.mutex} {}
+    delegate::BatchItemResult* operator->() { return &job.results[index]; }
+    void complete() {
+      auto copy = job.results[index];
+      auto window = job.window; // finish() resets it within complete()
+      lock.unlock();
+      job.delegate->onBatchItemCompleted(index, copy);
+      window->complete();
+    }
+  private:
+    BatchJob&                     job;
+    const std::size_t             index;
+    std::unique_lock<std::mutex>  lock;
+  }; // class BatchItemResultRef
+
+  // Drops the operations not started yet; finish() reports them as cancelled
+  void cancel() {
+    std::shared_ptr<AsyncWindow> window{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      window = this->window;
+    }
+    if (window) {
+      window->stop();
+    }
+  }
+
+  void finish() {
+    for (std::size_t index = 0; index < results.size(); ++index) {
+      if (!started[index]) {
+        // Only a cancelled batch leaves operations unstarted
+        auto& result = results[index];
+        result.error = options.cancellation.isCancelled()
+                         ? options.cancellation.error()
+                         : Error{cancelledErrorCode, "Cancelled",
+                                 "The operation was not started"};
+        result.context = cancelledContext(result.error);
+        delegate->onBatchItemCompleted(index, result);
+      }
+    }
+    auto results = std::move(this->results);
+    delegate->onBatchCompleted(std::move(results));
+    delegate.reset();
+    CancellationRegistration registration{};
+    std::lock_guard<std::mutex> lock{mutex};
+    window.reset();
+    registration = std::move(cancellation);
+  }
+
+  std::mutex                    mutex{};
+  delegate::BatchDelegatePtr    delegate;
+  const BatchOptions            options;
+  std::shared_ptr<AsyncWindow>  window{};
+  CancellationRegistration      cancellation{};
+  delegate::BatchResults        results;
+  std::vector<bool>             started;
+}; // class BatchJob
+
+template <class DelegateT, class ItemT>
+std::shared_ptr<DelegateT> makeBatchItemDelegate(BatchJob& job,
+                                                 std::size_t index) {
+  auto self = job.share();
+  return delegate::impl::makeFnDelegate<DelegateT>(
+    [self, index](ItemT&& item) { self->done(index, std::move(item)); },
+    [self, index](delegate::Error&& error, cbe::util::Context&& context) {
+      self->failed(index, std::move(error), std::move(context));
+    });
+}
+
+template <class DelegateT, class SuccessT>
+std::shared_ptr<DelegateT> makeBatchRemoveDelegate(BatchJob& job,
+                                                   std::size_t index) {
+  auto self = job.share();
+  return delegate::impl::makeFnDelegate<DelegateT>(
+    [self, index](SuccessT&&) {
+      self->done(index, cbe::Item{cbe::DefaultCtor{}});
+    },
+    [self, index](delegate::Error&& error, cbe::util::Context&& context) {
+      self->failed(index, std::move(error), std::move(context));
+    });
+}
+
+inline void unsupportedItem(BatchJob& job, std::size_t index) {
+  job.failed(index,
+             delegate::Error{400, "Bad Request",
+                             "Only containers and objects are supported"},
+             cbe::util::Context{});
+}
+
+#ifndef CBE_NO_SYNC
+class BatchWaiter : public delegate::BatchDelegate {
+public:
+  delegate::BatchResults wait() {
+    signal.wait();
+    return std::move(results);
+  }
+private:
+  void onBatchCompleted(delegate::BatchResults&& results) override {
+    this->results = std::move(results);
+    signal.notify();
+  }
+
+  SyncSignal              signal{};
+  delegate::BatchResults  results{};
+}; // class BatchWaiter
+#endif // #ifndef CBE_NO_SYNC
+
+    } // namespace impl
+
+/**
+ * @brief Moves a list of items to the container \p dstId.
+ *
+ * Applies cbe::Container::move() or cbe::Object::move() on each of the
+ * \p items, which may reside in different containers, e.g., the items of a
+ * search result. The calls are pipelined, up to BatchOptions::maxInFlight at
+ * the same time, and the outcome per item is reported through
+ * delegate::BatchDelegate::onBatchCompleted().
+ *
+ * @param items     The containers and objects to move.
+ * @param dstId     Id of the container to which the items shall be moved.
+ * @param delegate  Pointer to a delegate::BatchDelegate instance that is
+ *                  implemented by the user.
+ * @param options   Tuning of the batch, see BatchOptions.
+ */
+inline void moveItems(cbe::Items                  items,
+                      cbe::ContainerId            dstId,
+                      delegate::BatchDelegatePtr  delegate,
+                      const BatchOptions&         options) {
+  auto job = std::make_shared<impl::BatchJob>(items.size(), std::move(delegate),
+                                              options);
+  auto shared = std::make_shared<cbe::Items>(std::move(items));
+  job->start([shared, dstId](impl::BatchJob& job, std::size_t index) {
+    auto& item = (*shared)[index];
+    job.setItemId(index, item.id());
+    if (item.type() == cbe::ItemType::Container) {
+      cbe::CloudBackend::castContainer(item).move(
+        dstId,
+        impl::makeBatchItemDelegate<delegate::container::MoveDelegate,
+                                    cbe::Container>(job, index));
+    } else if (item.type() == cbe::ItemType::Object) {
+      cbe::CloudBackend::castObject(item).move(
+        dstId,
+        impl::makeBatchItemDelegate<delegate::object::MoveDelegate,
+                                    cbe::Object>(job, index));
+    } else {
+      impl::unsupportedItem(job, index);
+    }
+  });
+}
+/**
+ * Same as moveItems(cbe::Items,cbe::ContainerId,delegate::BatchDelegatePtr,const BatchOptions&),
+ * but with default BatchOptions.
+ */
+inline void moveItems(cbe::Items                  items,
+                      cbe::ContainerId            dstId,
+                      delegate::BatchDelegatePtr  delegate) {
+  moveItems(std::move(items), dstId, std::move(delegate), BatchOptions{});
+}
+
+/**
+ * @brief Renames a list of items.
+ *
+ * Applies cbe::Container::rename() or cbe::Object::rename() on each item of
+ * \p renames with its paired new name.
+ * See moveItems(cbe::Items,cbe::ContainerId,delegate::BatchDelegatePtr,const BatchOptions&)
+ * regarding pipelining and result reporting.
+ *
+ * @param renames   The containers and objects to rename, paired with their
+ *                  new names.
+ * @param delegate  Pointer to a delegate::BatchDelegate instance that is
+ *                  implemented by the user.
+ * @param options   Tuning of the batch, see BatchOptions.
+ */
+inline void renameItems(ItemRenames                 renames,
+                        delegate::BatchDelegatePtr  delegate,
+                        const BatchOptions&         options) {
+  auto job = std::make_shared<impl::BatchJob>(renames.size(),
+                                              std::move(delegate), options);
+  auto shared = std::make_shared<ItemRenames>(std::move(renames));
+  job->start([shared](impl::BatchJob& job, std::size_t index) {
+    auto& item = (*shared)[index].first;
+    const auto& name = (*shared)[index].second;
+    job.setItemId(index, item.id());
+    if (item.type() == cbe::ItemType::Container) {
+      cbe::CloudBackend::castContainer(item).rename(
+        name,
+        impl::makeBatchItemDelegate<delegate::container::RenameDelegate,
+                                    cbe::Container>(job, index));
+    } else if (item.type() == cbe::ItemType::Object) {
+      cbe::CloudBackend::castObject(item).rename(
+        name,
+        impl::makeBatchItemDelegate<delegate::object::RenameDelegate,
+                                    cbe::Object>(job, index));
+    } else {
+      impl::unsupportedItem(job, index);
+    }
+  });
+}
+/**
+ * Same as renameItems(ItemRenames,delegate::BatchDelegatePtr,const BatchOptions&),
+ * but with default BatchOptions.
+ */
+inline void renameItems(ItemRenames                 renames,
+                        delegate::BatchDelegatePtr  delegate) {
+  renameItems(std::move(renames), std::move(delegate), BatchOptions{});
+}
+
+/**
+ * @brief Removes a list of items.
+ *
+ * Applies cbe::Container::remove() or cbe::Object::remove() on each of the
+ * \p items. A removed container takes its content with it.
+ * See moveItems(cbe::Items,cbe::ContainerId,delegate::BatchDelegatePtr,const BatchOptions&)
+ * regarding pipelining and result reporting.
+ *
+ * @param items     The containers and objects to remove.
+ * @param delegate  Pointer to a delegate::BatchDelegate instance that is
+ *                  implemented by the user.
+ * @param options   Tuning of the batch, see BatchOptions.
+ */
+inline void removeItems(cbe::Items                  items,
+                        delegate::BatchDelegatePtr  delegate,
+                        const BatchOptions&         options) {
+  auto job = std::make_shared<impl::BatchJob>(items.size(), std::move(delegate),
+                                              options);
+  auto shared = std::make_shared<cbe::Items>(std::move(items));
+  job->start([shared](impl::BatchJob& job, std::size_t index) {
+    auto& item = (*shared)[index];
+    job.setItemId(index, item.id());
+    if (item.type() == cbe::ItemType::Container) {
+      cbe::CloudBackend::castContainer(item).remove(
+        impl::makeBatchRemoveDelegate<delegate::container::RemoveDelegate,
+                                      delegate::container::RemoveSuccess>(
+                                                                  job, index));
+    } else if (item.type() == cbe::ItemType::Object) {
+      cbe::CloudBackend::castObject(item).remove(
+        impl::makeBatchRemoveDelegate<delegate::object::RemoveDelegate,
+                                      delegate::object::RemoveSuccess>(
+                                                                  job, index));
+    } else {
+      impl::unsupportedItem(job, index);
+    }
+  });
+}
+/**
+ * Same as removeItems(cbe::Items,delegate::BatchDelegatePtr,const BatchOptions&),
+ * but with default BatchOptions.
+ */
+inline void removeItems(cbe::Items                  items,
+                        delegate::BatchDelegatePtr  delegate) {
+  removeItems(std::move(items), std::move(delegate), BatchOptions{});
+}
+
+#ifndef CBE_NO_SYNC
+/**
+ * @brief Synchronous moveItems
+ *
+ * <b>Synchronous</b> version of
+ * moveItems(cbe::Items,cbe::ContainerId,delegate::BatchDelegatePtr,const BatchOptions&).
+ * Throws no exception for failed items, the outcome of each item is found in
+ * the returned results.
+ *
+ * @return One entry per item, in the order the items were passed in.
+ */
+inline delegate::BatchResults moveItems(cbe::Items          items,
+                                        cbe::ContainerId    dstId,
+                                        const BatchOptions& options) {
+  auto waiter = std::make_shared<impl::BatchWaiter>();
+  moveItems(std::move(items), dstId, waiter, options);
+  return waiter->wait();
+}
+/**
+ * Same as moveItems(cbe::Items,cbe::ContainerId,const BatchOptions&),
+ * but with default BatchOptions.
+ */
+inline delegate::BatchResults moveItems(cbe::Items        items,
+                                        cbe::ContainerId  dstId) {
+  return moveItems(std::move(items), dstId, BatchOptions{});
+}
+/**
+ * @brief Synchronous renameItems
+ *
+ * <b>Synchronous</b> version of
+ * renameItems(ItemRenames,delegate::BatchDelegatePtr,const BatchOptions&).
+ * See moveItems(cbe::Items,cbe::ContainerId,const BatchOptions&).
+ */
+inline delegate::BatchResults renameItems(ItemRenames         renames,
+                                          const BatchOptions& options) {
+  auto waiter = std::make_shared<impl::BatchWaiter>();
+  renameItems(std::move(renames), waiter, options);
+  return waiter->wait();
+}
+/**
+ * Same as renameItems(ItemRenames,const BatchOptions&),
+ * but with default BatchOptions.
+ */
+inline delegate::BatchResults renameItems(ItemRenames renames) {
+  return renameItems(std::move(renames), BatchOptions{});
+}
+/**
+ * @brief Synchronous removeItems
+ *
+ * <b>Synchronous</b> version of
+ * removeItems(cbe::Items,delegate::BatchDelegatePtr,const BatchOptions&).
+ * See moveItems(cbe::Items,cbe::ContainerId,const BatchOptions&).
+ */
+inline delegate::BatchResults removeItems(cbe::Items          items,
+                                          const BatchOptions& options) {
+  auto waiter = std::make_shared<impl::BatchWaiter>();
+  removeItems(std::move(items), waiter, options);
+  return waiter->wait();
+}
+/**
+ * Same as removeItems(cbe::Items,const BatchOptions&),
+ * but with default BatchOptions.
+ */
+inline delegate::BatchResults removeItems(cbe::Items items) {
+  return removeItems(std::move(items), BatchOptions{});
+}
+#endif // #ifndef CBE_NO_SYNC
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Batch_h__
@@ -0,0 +1,235 @@
+#ifndef CBE__util__BatchListener_h__
+#define CBE__util__BatchListener_h__
+
+#include "cbe/Types.h"
+
+#include "cbe/delegate/BatchListenerDelegate.h"
+#include "cbe/delegate/ChangeEvent.h"
+
+#include "cbe/util/Executor.h"
+#include "cbe/util/impl/ChangeEventListener.h"
+#include "cbe/util/impl/Timer.h"
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+/**
+ * @file
+ * Batched delivery of the remote changes to a listener.
+ *
+ * Pass a BatchListener into cbe::CloudBackend::addListener() in place of a
+ * CloudBackendListenerDelegate, e.g.:
+ * @code
+ *   cloudBackend.addListener(cbe::util::batchListener(myBatchListener));
+ * @endcode
+ */
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Tuning of a BatchListener.
+ */
+struct BatchListenerOptions {
+  /**
+   * Time from the first change of a batch until the batch is delivered.
+   */
+  std::chrono::milliseconds window{100};
+  /**
+   * A batch is delivered before the end of its window once it holds this many
+   * events.
+   */
+  std::size_t   maxBatchSize = 10000;
+  /**
+   * Coalesces repeated changes of the same item within a batch into one
+   * event, holding the latest state of the item:
+   * <ul>
+   *   <li> the kinds of the changes are combined in ChangeEvent::kinds,
+   *   <li> an item both added and removed within the batch is left out,
+   *   <li> a removal supersedes the earlier moves and renames.
+   * </ul>
+   */
+  bool          coalesce = true;
+  /**
+   * Executor the batches are delivered on, one at a time. If empty, a thread
+   * dedicated to the listener is used.
+   */
+  ExecutorPtr   executor{};
+}; // struct BatchListenerOptions
+
+    namespace impl {
+
+class BatchBuffer {
+public:
+  using ChangeEvent   = delegate::ChangeEvent;
+  using ChangeEvents  = delegate::ChangeEvents;
+
+  BatchBuffer(delegate::BatchListenerDelegatePtr  listener,
+              BatchListenerOptions                options)
+    : listener{std::move(listener)}, options{std::move(options)},
+      strand{std::make_shared<Strand>(
+        this->options.executor ? this->options.executor
+                               : std::make_shared<ThreadPoolExecutor>(1))} {}
+
+  BatchBuffer(const BatchBuffer&) = delete;
+  BatchBuffer& operator=(const BatchBuffer&) = delete;
+
+  void add(ChangeEvent&& event, const std::shared_ptr<BatchBuffer>& self) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (!options.coalesce || !coalesce(event)) {
+      if (options.coalesce) {
+        index[Key{event.itemType, event.itemId}] = events.size();
+      }
+      events.push_back(std::move(event));
+    }
+    if (events.size() >= options.maxBatchSize) {
+      deliver();
+    } else if (!timer) {
+      std::weak_ptr<BatchBuffer> weakSelf = self;
+      const auto batch = batches;
+      timer = Timer::instance().schedule(
+        Timer::Clock::now() + options.window,
+        [weakSelf, batch]() {
+          auto self = weakSelf.lock();
+          if (!self) {
+            return;
+          }
+          std::lock_guard<std::mutex> lock{self->mutex};
+          // Unless delivered meanwhile, e.g., on reaching maxBatchSize
+          if (self->batches == batch) {
+            self->timer = 0;
+            self->deliver();
+          }
+        });
+    }
+  }
+
+  void flush() {
+    std::lock_guard<std::mutex> lock{mutex};
+    deliver();
+  }
+
+private:
+  using Key = std::pair<cbe::ItemType, cbe::ItemId>;
+
+  // Merges event into the pending event of the same item, if any
+  bool coalesce(ChangeEvent& event) {
+    auto found = index.find(Key{event.itemType, event.itemId});
+    if (found == index.end()) {
+      return false;
+    }
+    impl::coalesce(events[found->second], std::move(event));
+    return true;
+  }
+
+  // Posts the pending events, called with the mutex held so that the batches
+  // are posted to the strand in the order they were formed
+  void deliver() {
+    if (timer) {
+      Timer::instance().unschedule(timer);
+      timer = 0;
+    }
+    ++batches;
+    if (events.empty()) {
+      return;
+    }
+    ChangeEvents batch{};
+    batch.reserve(events.size());
+    for (auto& event : events) {
+      if (event.kinds) { // Not added and removed within the batch
+        batch.push_back(std::move(event));
+      }
+    }
+    events.clear();
+    index.clear();
+    if (batch.empty()) {
+      return;
+    }
+    const auto listener = this->listener;
+    const auto delivered = std::make_shared<ChangeEvents>(std::move(batch));
+    strand->post([listener, delivered]() {
+      listener->onRemoteChanges(std::move(*delivered));
+    });
+  }
+
+  const delegate::BatchListenerDelegatePtr  listener;
+  const BatchListenerOptions                options;
+  const std::shared_ptr<Strand>             strand;
+  std::mutex                                mutex{};
+  ChangeEvents                              events{};
+  std::map<Key, std::size_t>                index{};
+  Timer::Id                                 timer{};
+  std::size_t                               batches{};
+}; // class BatchBuffer
+
+    } // namespace impl
+
+/**
+ * @brief Listener that collects the remote changes and delivers them in
+ *        batches to a delegate::BatchListenerDelegate.
+ *
+ * A batch is formed from the changes received within a window starting at its
+ * first change, see BatchListenerOptions. Whatever is pending when the
+ * BatchListener is destroyed, i.e., after cbe::CloudBackend::removeListener(),
+ * is still delivered.
+ */
+class BatchListener final : public impl::ChangeEventListener {
+public:
+  BatchListener(delegate::BatchListenerDelegatePtr  listener,
+                BatchListenerOptions                options)
+    : buffer{std::make_shared<impl::BatchBuffer>(std::move(listener),
+                                                 std::move(options))} {}
+  /**
+   * Same as BatchListener(delegate::BatchListenerDelegatePtr,BatchListenerOptions),
+   * with the default options.
+   */
+  explicit BatchListener(delegate::BatchListenerDelegatePtr listener)
+    : BatchListener{std::move(listener), BatchListenerOptions{}} {}
+
+  BatchListener(const BatchListener&) = delete;
+  BatchListener& operator=(const BatchListener&) = delete;
+
+  ~BatchListener() override { buffer->flush(); }
+
+  /**
+   * Delivers the pending changes now, without waiting for the window to end.
+   */
+  void flush() { buffer->flush(); }
+
+protected:
+  void onChange(ChangeEvent&& event) override {
+    buffer->add(std::move(event), buffer);
+  }
+
+private:
+  std::shared_ptr<impl::BatchBuffer> buffer;
+}; // class BatchListener
+
+/**
+ * @brief Creates a BatchListener, to be passed into
+ *        cbe::CloudBackend::addListener().
+ */
+inline std::shared_ptr<BatchListener> batchListener(
+                                  delegate::BatchListenerDelegatePtr  listener,
+                                  BatchListenerOptions                options) {
+  return std::make_shared<BatchListener>(std::move(listener),
+                                         std::move(options));
+}
+
+/**
+ * Same as batchListener(delegate::BatchListenerDelegatePtr,BatchListenerOptions),
+ * with the default options.
+ */
+inline std::shared_ptr<BatchListener> batchListener(
+                                  delegate::BatchListenerDelegatePtr listener) {
+  return batchListener(std::move(listener), BatchListenerOptions{});
+}
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__BatchListener_h__
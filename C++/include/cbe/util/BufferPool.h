@@ -0,0 +1,446 @@
+#ifndef CBE__util__BufferPool_h__
+#define CBE__util__BufferPool_h__
+
+#include "cbe/Container.h"
+#include "cbe/Object.h"
+
+#include "cbe/delegate/UploadDelegate.h"
+
+#include "cbe/util/Context.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/**
+ * @file
+ * Bounded, observable memory for transfers and results.
+ *
+ * Requires C++17.
+ */
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Live bytes of one subsystem, e.g., the transfer buffers or the
+ *        results of queries, updated by the allocations it is passed to.
+ */
+class MemoryCounter {
+public:
+  void allocated(std::size_t bytes) {
+    raisePeak(liveBytes.fetch_add(bytes) + bytes);
+  }
+
+  /**
+   * Counts \p bytes as allocated unless live() would exceed \p maxBytes, so
+   * that concurrent allocations cannot together exceed it.
+   *
+   * @return \c false if not counted.
+   */
+  bool tryAllocate(std::size_t bytes, std::size_t maxBytes) {
+    auto live = liveBytes.load();
+    do {
+      if (bytes > maxBytes || live > maxBytes - bytes) {
+        return false;
+      }
+    } while (!liveBytes.compare_exchange_weak(live, live + bytes));
+    raisePeak(live + bytes);
+    return true;
+  }
+
+  void released(std::size_t bytes) { liveBytes.fetch_sub(bytes); }
+
+  /** Bytes allocated and not yet released. */
+  std::size_t live() const { return liveBytes.load(); }
+  /** Highest live() so far. */
+  std::size_t peak() const { return peakBytes.load(); }
+
+private:
+  void raisePeak(std::size_t now) {
+    auto peak = peakBytes.load();
+    while (now > peak && !peakBytes.compare_exchange_weak(peak, now)) {
+    }
+  }
+
+  std::atomic<std::size_t> liveBytes{};
+  std::atomic<std::size_t> peakBytes{};
+}; // class MemoryCounter
+
+/**
+ * @brief Memory resource that counts what it allocates from another, and
+ *        fails allocations beyond a cap with std::bad_alloc.
+ *
+ * E.g., as cbe::util::CompactItemsOptions::memoryResource, to account for
+ * and bound the memory of the results held.
+ */
+class CountingResource final : public std::pmr::memory_resource {
+public:
+  CountingResource(MemoryCounter&             counter,
+                   std::size_t                maxBytes,
+                   std::pmr::memory_resource* upstream)
+    : counter{counter}, maxBytes{maxBytes}, upstream{upstream} {}
+  /**
+   * Same as CountingResource(MemoryCounter&,std::size_t,std::pmr::memory_resource*),
+   * with no cap, over the default resource.
+   */
+  explicit CountingResource(MemoryCounter& counter)
+    : CountingResource{counter, std::numeric_limits<std::size_t>::max(),
+                       std::pmr::get_default_resource()} {}
+
+  CountingResource(const CountingResource&) = delete;
+  CountingResource& operator=(const CountingResource&) = delete;
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    // Reserved ahead, so that concurrent allocations respect the cap
+    if (!counter.tryAllocate(bytes, maxBytes)) {
+      throw std::bad_alloc{};
+    }
+    try {
+      return upstream->allocate(bytes, alignment);
+    } catch (...) {
+      counter.released(bytes);
+      throw;
+    }
+  }
+
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+    upstream->deallocate(p, bytes, alignment);
+    counter.released(bytes);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+                                                        noexcept override {
+    return this == &other;
+  }
+
+  MemoryCounter&                    counter;
+  const std::size_t                 maxBytes;
+  std::pmr::memory_resource* const  upstream;
+}; // class CountingResource
+
+/**
+ * @brief Tuning of a BufferPool.
+ */
+struct BufferPoolOptions {
+  /** Size of each buffer, in bytes. */
+  std::size_t                 chunkSize = std::size_t{1} << 20;
+  /**
+   * Cap on the memory of the pool, buffers in use and idle, in bytes; at
+   * least one chunk. BufferPool::acquire() waits for a buffer to be released
+   * rather than exceed it.
+   */
+  std::size_t                 maxBytes = std::size_t{64} << 20;
+  /**
+   * Aligns the buffers to 2 MiB and, on Linux, advises the kernel to back
+   * them with huge pages. Best with a chunk size multiple of 2 MiB.
+   */
+  bool                        hugePages = false;
+  /** The memory the buffers are allocated from. If null, the default resource. */
+  std::pmr::memory_resource*  memoryResource = nullptr;
+}; // struct BufferPoolOptions
+
+/**
+ * @brief Metrics of a BufferPool.
+ */
+struct BufferPoolStats {
+  /** Bytes of the buffers in use. */
+  std::size_t   live{};
+  /** Bytes of the buffers released and kept for reuse. */
+  std::size_t   idle{};
+  /** Highest live + idle so far. */
+  std::size_t   peak{};
+  std::uint64_t acquired{};
+  /** Buffers acquired that were reused rather than allocated. */
+  std::uint64_t reused{};
+  /** Acquisitions that had to wait for the cap. */
+  std::uint64_t waited{};
+}; // struct BufferPoolStats
+
+class BufferPool;
+
+/**
+ * @brief A buffer of a BufferPool, returned to it when destroyed.
+ */
+class Buffer {
+public:
+  Buffer() = default;
+  Buffer(Buffer&& other) noexcept { swap(other); }
+  Buffer& operator=(Buffer&& other) noexcept {
+    Buffer{std::move(other)}.swap(*this);
+    return *this;
+  }
+  Buffer(const Buffer&) = delete;
+  Buffer& operator=(const Buffer&) = delete;
+  ~Buffer();
+
+  char*       data() { return bytes; }
+  const char* data() const { return bytes; }
+  /** Capacity of the buffer, BufferPoolOptions::chunkSize. */
+  std::size_t size() const { return length; }
+
+  /** Whether the buffer holds memory. */
+  explicit operator bool() const { return bytes != nullptr; }
+
+  void swap(Buffer& other) noexcept {
+    std::swap(pool, other.pool);
+    std::swap(bytes, other.bytes);
+    std::swap(length, other.length);
+  }
+
+private:
+  friend class BufferPool;
+
+  Buffer(std::shared_ptr<BufferPool> pool, char* bytes, std::size_t length)
+    : pool{std::move(pool)}, bytes{bytes}, length{length} {}
+
+  std::shared_ptr<BufferPool> pool{};
+  char*                       bytes{};
+  std::size_t                 length{};
+}; // class Buffer
+
+/**
+ * @brief Fixed-size buffers for transfers, reused rather than allocated
+ *        anew, within a memory cap.
+ *
+ * E.g., to upload from memory, see upload(cbe::Container&,const std::string&,Buffer,std::uint64_t,delegate::UploadDelegatePtr),
+ * with a predictable footprint under a hard memory limit. Thread safe.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+public:
+  static constexpr std::size_t hugePageSize = std::size_t{2} << 20;
+
+  explicit BufferPool(BufferPoolOptions options)
+    : options{options},
+      memoryResource{options.memoryResource
+                       ? options.memoryResource
+                       : std::pmr::get_default_resource()} {
+    this->options.chunkSize = std::max<std::size_t>(this->options.chunkSize, 1);
+    this->options.maxBytes = std::max(this->options.maxBytes,
+                                      this->options.chunkSize);
+  }
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  ~BufferPool() {
+    for (auto* chunk : idle) {
+      free(chunk);
+    }
+  }
+
+  /**
+   * @return A buffer, once the cap allows for it.
+   */
+  Buffer acquire() {
+    std::unique_lock<std::mutex> lock{mutex};
+    ++metrics.acquired;
+    if (idle.empty() && full()) {
+      ++metrics.waited;
+      released.wait(lock, [this] { return !idle.empty() || !full(); });
+    }
+    return take(lock);
+  }
+
+  /**
+   * @return A buffer, or an empty one if the cap is reached.
+   */
+  Buffer tryAcquire() {
+    std::unique_lock<std::mutex> lock{mutex};
+    if (idle.empty() && full()) {
+      return Buffer{};
+    }
+    ++metrics.acquired;
+    return take(lock);
+  }
+
+  /**
+   * Frees the idle buffers.
+   */
+  void trim() {
+    std::vector<char*> chunks{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      chunks.swap(idle);
+      metrics.idle = 0;
+    }
+    for (auto* chunk : chunks) {
+      free(chunk);
+    }
+    released.notify_all();
+  }
+
+  BufferPoolStats stats() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return metrics;
+  }
+
+  /**
+   * @return The live bytes of the pool, in use and idle, e.g., to report
+   *         next to other subsystems.
+   */
+  const MemoryCounter& counter() const { return memory; }
+
+  std::size_t chunkSize() const { return options.chunkSize; }
+
+private:
+  friend class Buffer;
+
+  bool full() const {
+    return metrics.live + metrics.idle + options.chunkSize > options.maxBytes;
+  }
+
+  Buffer take(std::unique_lock<std::mutex>& lock) {
+    // Counted before allocating, so that the cap holds meanwhile
+    metrics.live += options.chunkSize;
+    if (!idle.empty()) {
+      auto* chunk = idle.back();
+      idle.pop_back();
+      metrics.idle -= options.chunkSize;
+      ++metrics.reused;
+      return Buffer{shared_from_this(), chunk, options.chunkSize};
+    }
+    metrics.peak = std::max(metrics.peak, metrics.live + metrics.idle);
+    lock.unlock();
+    try {
+      return Buffer{shared_from_this(), allocate(), options.chunkSize};
+    } catch (...) {
+      lock.lock();
+      metrics.live -= options.chunkSize;
+      lock.unlock();
+      released.notify_one();
+      throw;
+    }
+  }
+
+  void release(char* chunk) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      metrics.live -= options.chunkSize;
+      metrics.idle += options.chunkSize;
+      idle.push_back(chunk);
+    }
+    released.notify_one();
+  }
+
+  std::size_t alignment() const {
+    return options.hugePages ? hugePageSize : alignof(std::max_align_t);
+  }
+
+  char* allocate() {
+    auto* chunk = memoryResource->allocate(options.chunkSize, alignment());
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (options.hugePages) {
+      ::madvise(chunk, options.chunkSize, MADV_HUGEPAGE); // Advisory only
+    }
+#endif
+    memory.allocated(options.chunkSize);
+    return static_cast<char*>(chunk);
+  }
+
+  void free(char* chunk) {
+    memoryResource->deallocate(chunk, options.chunkSize, alignment());
+    memory.released(options.chunkSize);
+  }
+
+  BufferPoolOptions                 options;
+  std::pmr::memory_resource* const  memoryResource;
+  mutable std::mutex                mutex{};
+  std::condition_variable           released{};
+  std::vector<char*>                idle{};
+  BufferPoolStats                   metrics{};
+  MemoryCounter                     memory{};
+}; // class BufferPool
+
+inline Buffer::~Buffer() {
+  if (bytes) {
+    pool->release(bytes);
+  }
+}
+
+/**
+ * @brief Creates a BufferPool.
+ */
+inline std::shared_ptr<BufferPool> bufferPool(BufferPoolOptions options) {
+  return std::make_shared<BufferPool>(options);
+}
+
+/**
+ * Same as bufferPool(BufferPoolOptions), with the default options.
+ */
+inline std::shared_ptr<BufferPool> bufferPool() {
+  return bufferPool(BufferPoolOptions{});
+}
+
+    namespace impl {
+
+/**
+ * @brief Holds the buffer of an upload until it has completed.
+ */
+class BufferUploadDelegate final : public delegate::UploadDelegate {
+public:
+  BufferUploadDelegate(Buffer buffer, delegate::UploadDelegatePtr delegate)
+    : buffer{std::move(buffer)}, delegate{std::move(delegate)} {}
+
+  void onUploadSuccess(cbe::Object&& object) override {
+    Buffer{std::move(buffer)}; // Released before the callback
+    delegate->onUploadSuccess(std::move(object));
+  }
+  void onUploadError(delegate::TransferError&& error,
+                     cbe::util::Context&&      context) override {
+    Buffer{std::move(buffer)};
+    delegate->onUploadError(std::move(error), std::move(context));
+  }
+  void onChunkSent(cbe::Object&&  object,
+                   std::uint64_t  sent,
+                   std::uint64_t  total) override {
+    delegate->onChunkSent(std::move(object), sent, total);
+  }
+
+private:
+  Buffer                      buffer;
+  delegate::UploadDelegatePtr delegate;
+}; // class BufferUploadDelegate
+
+    } // namespace impl
+
+/**
+ * Uploads the first \p length bytes of \p buffer to a new object, see
+ * cbe::Container::upload(const std::string&,std::uint64_t,const char*,UploadDelegatePtr).
+ * The buffer is returned to its pool once the upload has completed.
+ */
+inline cbe::Object upload(cbe::Container&             container,
+                          const std::string&          name,
+                          Buffer                      buffer,
+                          std::uint64_t               length,
+                          delegate::UploadDelegatePtr delegate) {
+  // Taken before the buffer is moved from, the arguments being evaluated in
+  // any order
+  const char* data = buffer.data();
+  const auto size = std::min<std::uint64_t>(length, buffer.size());
+  return container.upload(
+    name, size, data,
+    std::make_shared<impl::BufferUploadDelegate>(std::move(buffer),
+                                                 std::move(delegate)));
+}
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__BufferPool_h__
@@ -0,0 +1,458 @@
+#ifndef CBE__util__Cancellation_h__
+#define CBE__util__Cancellation_h__
+
+#include "cbe/Types.h"
+
+#include "cbe/delegate/Error.h"
+#include "cbe/delegate/TransferError.h"
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Context.h"
+#include "cbe/util/impl/Timer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * Error code reported through the error callback of a delegate whose call was
+ * cancelled through a CancellationToken, borrowed from the non-standard HTTP
+ * status "Client Closed Request".
+ */
+constexpr cbe::ErrorCode cancelledErrorCode = 499;
+
+    namespace impl {
+
+class CancellationState {
+public:
+  using Callback = std::function<void()>;
+  using Id = std::uint64_t;
+
+  bool isCancelled() const {
+    return cancelled.load(std::memory_order_acquire);
+  }
+
+  delegate::Error error() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return error_;
+  }
+
+  // Returns false, without keeping the callback, if already cancelled
+  bool add(Id& id, Callback&& callback) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (isCancelled()) {
+      return false;
+    }
+    id = ++lastId;
+    callbacks.emplace(id, std::move(callback));
+    return true;
+  }
+
+  void remove(Id id) {
+    Callback removed{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      auto it = callbacks.find(id);
+      if (it == callbacks.end()) {
+        return;
+      }
+      removed = std::move(it->second);
+      callbacks.erase(it);
+    }
+    // The callback, and what it owns, is destroyed outside the lock
+  }
+
+  // Keeps \p resource alive as long as the state, e.g., the timer of a deadline
+  void keep(std::shared_ptr<void> resource) {
+    std::lock_guard<std::mutex> lock{mutex};
+    resources.push_back(std::move(resource));
+  }
+
+  void cancel(delegate::Error&& error) {
+    std::map<Id, Callback> pending{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (isCancelled()) {
+        return;
+      }
+      error_ = std::move(error);
+      cancelled.store(true, std::memory_order_release);
+      pending.swap(callbacks);
+    }
+    for (auto& entry : pending) {
+      entry.second();
+    }
+  }
+
+private:
+  mutable std::mutex      mutex{};
+  std::atomic<bool>       cancelled{false};
+  delegate::Error         error_{};
+  Id                      lastId{};
+  std::map<Id, Callback>  callbacks{};
+  std::vector<std::shared_ptr<void>> resources{};
+}; // class CancellationState
+
+// Unschedules the timer of CancellationSource::cancelAt() once the state is
+// released, i.e., nobody is interested in the cancellation any more
+class CancellationTimer {
+public:
+  explicit CancellationTimer(Timer::Id id) : id{id} {}
+  CancellationTimer(const CancellationTimer&) = delete;
+  CancellationTimer& operator=(const CancellationTimer&) = delete;
+  ~CancellationTimer() { Timer::instance().unschedule(id); }
+private:
+  const Timer::Id id;
+}; // class CancellationTimer
+
+inline cbe::util::Context cancelledContext(const delegate::Error& error) {
+  auto reason = error.reason;
+  return cbe::util::Context{[reason](std::ostream& os) {
+                              os << "cancelled=true\n"
+                                 << "cancelReason=" << reason << '\n';
+                            },
+                            "cancel"};
+}
+
+/**
+ * Converts a delegate::Error, e.g., the error of a cancelled
+ * CancellationState, into the error type of a delegate interface.
+ */
+template <class ErrorT>
+struct ErrorAs {
+  static ErrorT make(delegate::Error&& error) {
+    return ErrorT{error.errorCode, std::move(error.reason),
+                  std::move(error.message)};
+  }
+}; // struct ErrorAs
+
+template <>
+struct ErrorAs<delegate::TransferError> {
+  static delegate::TransferError make(delegate::Error&& error) {
+    return delegate::TransferError{std::move(error), std::string{},
+                                   cbe::ObjectId{}, cbe::ContainerId{}};
+  }
+}; // struct ErrorAs<delegate::TransferError>
+
+    } // namespace impl
+
+/**
+ * @brief Unregisters a callback registered through CancellationToken::onCancel()
+ *        when destroyed or reset.
+ */
+class CancellationRegistration {
+public:
+  CancellationRegistration() = default;
+  CancellationRegistration(std::weak_ptr<impl::CancellationState> state,
+                           impl::CancellationState::Id            id)
+    : state{std::move(state)}, id{id} {}
+
+  CancellationRegistration(CancellationRegistration&& other) noexcept
+    : state{std::move(other.state)}, id{other.id} {
+    other.state.reset();
+  }
+  CancellationRegistration& operator=(CancellationRegistration&& other) noexcept {
+    if (this != &other) {
+      reset();
+      state = std::move(other.state);
+      id = other.id;
+      other.state.reset();
+    }
+    return *this;
+  }
+  CancellationRegistration(const CancellationRegistration&) = delete;
+  CancellationRegistration& operator=(const CancellationRegistration&) = delete;
+
+  ~CancellationRegistration() { reset(); }
+
+  void reset() {
+    if (auto locked = state.lock()) {
+      locked->remove(id);
+    }
+    state.reset();
+  }
+
+private:
+  std::weak_ptr<impl::CancellationState>  state{};
+  impl::CancellationState::Id             id{};
+}; // class CancellationRegistration
+
+/**
+ * @brief Observes whether the calls it was passed into are to be cancelled.
+ *
+ * Obtained from CancellationSource::token(), and cheap to copy. A default
+ * constructed token is never cancelled.
+ *
+ * \note The SDK offers no way to abort a request once sent, short of
+ * cbe::CloudBackend::terminate(). Cancellation is therefore cooperative:
+ * a cancelled call completes its delegate right away with an error of code
+ * cancelledErrorCode, the late response of the service is dropped, and the
+ * multi-call jobs of cbe::util, e.g., copySubtree() and moveItems(), stop
+ * issuing further calls.
+ */
+class CancellationToken {
+public:
+  using Callback = impl::CancellationState::Callback;
+
+  CancellationToken() = default;
+
+  /**
+   * @return <code><b>true</b></code> once the CancellationSource has been
+   *         cancelled.
+   */
+  bool isCancelled() const { return state && state->isCancelled(); }
+
+  /**
+   * @return <code><b>false</b></code> for a default constructed token, which
+   *         is never cancelled.
+   */
+  bool canBeCancelled() const { return static_cast<bool>(state); }
+
+  /**
+   * @return The error that cancelled calls are completed with, i.e., error
+   *         code cancelledErrorCode, or the code passed into
+   *         CancellationSource::cancel(delegate::Error&&).
+   */
+  delegate::Error error() const {
+    return state ? state->error() : delegate::Error{};
+  }
+
+  /**
+   * Registers \p callback to be invoked, on the thread cancelling the source,
+   * once cancelled. The callback is invoked immediately should the token
+   * already be cancelled, and never for a default constructed token.
+   *
+   * @return Registration that unregisters the callback when destroyed.
+   */
+  CancellationRegistration onCancel(Callback callback) const {
+    if (!state) {
+      return {};
+    }
+    impl::CancellationState::Id id{};
+    if (!state->add(id, std::move(callback))) {
+      callback();
+      return {};
+    }
+    return {state, id};
+  }
+
+private:
+  friend class CancellationSource;
+  explicit CancellationToken(std::shared_ptr<impl::CancellationState> state)
+    : state{std::move(state)} {}
+
+  std::shared_ptr<impl::CancellationState> state{};
+}; // class CancellationToken
+
+/**
+ * @brief Cancels the calls that its tokens were passed into.
+ *
+ * \par Example
+ * \code {.cpp}
+ * cbe::util::CancellationSource cancellation{};
+ * object.download(path, cbe::delegate::makeDelegate<cbe::delegate::DownloadDelegate>(
+ *   cancellation.token(),
+ *   [](cbe::delegate::DownloadSuccess&& downloaded) { ... },
+ *   [](cbe::delegate::TransferError&& error, cbe::util::Context&& context) {
+ *     if (error.errorCode == cbe::util::cancelledErrorCode) { ... }
+ *   }));
+ * ...
+ * cancellation.cancel(); // e.g., when the user navigates away
+ * \endcode
+ */
+class CancellationSource {
+public:
+  using Clock = impl::Timer::Clock;
+
+  CancellationSource() : state{std::make_shared<impl::CancellationState>()} {}
+
+  /**
+   * Creates a source that is also cancelled, with the same error, when
+   * \p parent is cancelled, e.g., to add a deadline to a token of the user.
+   */
+  explicit CancellationSource(const CancellationToken& parent)
+    : CancellationSource{} {
+    std::weak_ptr<impl::CancellationState> weakState = state;
+    std::weak_ptr<impl::CancellationState> weakParent = parent.state;
+    state->keep(std::make_shared<CancellationRegistration>(
+      parent.onCancel([weakState, weakParent]() {
+        auto state = weakState.lock();
+        auto parent = weakParent.lock();
+        if (state && parent) {
+          state->cancel(parent->error());
+        }
+      })));
+  }
+
+  CancellationToken token() const { return CancellationToken{state}; }
+
+  bool isCancelled() const { return state->isCancelled(); }
+
+  /**
+   * Cancels the calls that the tokens of this source were passed into.
+   * Only the first call has any effect.
+   */
+  void cancel() {
+    cancel(delegate::Error{cancelledErrorCode, "Cancelled",
+                           "The call was cancelled by the client"});
+  }
+
+  /**
+   * Same as cancel(), but completes the cancelled calls with \p error.
+   */
+  void cancel(delegate::Error&& error) { state->cancel(std::move(error)); }
+
+  /**
+   * Cancels with \p error at the point in time \p at, unless cancelled
+   * before. The timer is dropped together with the last token and source.
+   */
+  void cancelAt(Clock::time_point at, delegate::Error&& error) {
+    std::weak_ptr<impl::CancellationState> weakState = state;
+    auto id = impl::Timer::instance().schedule(
+      at,
+      [weakState, error]() mutable {
+        if (auto state = weakState.lock()) {
+          state->cancel(std::move(error));
+        }
+      });
+    state->keep(std::make_shared<impl::CancellationTimer>(id));
+  }
+
+private:
+  std::shared_ptr<impl::CancellationState> state;
+}; // class CancellationSource
+
+    namespace impl {
+
+/**
+ * @brief State shared by a cancellable delegate and the callback registered on
+ *        its token; whichever completes first wins.
+ */
+template <class DelegateT, class SuccessFnT, class ErrorFnT>
+class CancellableCall {
+public:
+  using Success = typename DelegateT::Success;
+  using Error = typename DelegateT::Error;
+
+  CancellableCall(CancellationToken token,
+                  SuccessFnT        successFn,
+                  ErrorFnT          errorFn)
+    : token{std::move(token)}, successFn{std::move(successFn)},
+      errorFn{std::move(errorFn)} {}
+
+  void succeed(Success&& success) {
+    if (claim()) {
+      successFn(std::move(success));
+    }
+  }
+
+  void fail(Error&& error, cbe::util::Context&& context) {
+    if (claim()) {
+      errorFn(std::move(error), std::move(context));
+    }
+  }
+
+  void cancel() {
+    if (claim()) {
+      auto error = token.error();
+      auto context = cancelledContext(error);
+      errorFn(ErrorAs<Error>::make(std::move(error)),
+              std::move(context));
+    }
+  }
+
+  void setRegistration(CancellationRegistration&& registration) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (!completed) {
+      this->registration = std::move(registration);
+    }
+  }
+
+private:
+  bool claim() {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (completed) {
+      return false;
+    }
+    completed = true;
+    registration.reset();
+    return true;
+  }
+
+  const CancellationToken   token;
+  std::mutex                mutex{};
+  bool                      completed{};
+  CancellationRegistration  registration{};
+  SuccessFnT                successFn;
+  ErrorFnT                  errorFn;
+}; // class CancellableCall
+
+/**
+ * Creates a CancellableCall completed with the error of \p token should the
+ * token be cancelled before the call completes. The token holds on to the call
+ * weakly only, hence a call that is never cancelled is released together with
+ * its owner, e.g., its delegate.
+ */
+template <class DelegateT, class SuccessFnT, class ErrorFnT>
+std::shared_ptr<CancellableCall<DelegateT,
+                                typename std::decay<SuccessFnT>::type,
+                                typename std::decay<ErrorFnT>::type>>
+makeCancellableCall(const CancellationToken& token,
+                    SuccessFnT&&             successFn,
+                    ErrorFnT&&               errorFn) {
+  using Call = CancellableCall<DelegateT,
+                               typename std::decay<SuccessFnT>::type,
+                               typename std::decay<ErrorFnT>::type>;
+  auto call = std::make_shared<Call>(token,
+                                     std::forward<SuccessFnT>(successFn),
+                                     std::forward<ErrorFnT>(errorFn));
+  std::weak_ptr<Call> weakCall = call;
+  call->setRegistration(token.onCancel([weakCall]() {
+    if (auto call = weakCall.lock()) {
+      call->cancel();
+    }
+  }));
+  return call;
+}
+
+/**
+ * Creates a delegate::impl::FnDelegate that is completed with the error of
+ * \p token should the token be cancelled before the call completes, after
+ * which the response of the call is ignored.
+ */
+template <class DelegateT, class SuccessFnT, class ErrorFnT>
+std::shared_ptr<DelegateT> makeCancellableFnDelegate(
+                                            const CancellationToken& token,
+                                            SuccessFnT&&             successFn,
+                                            ErrorFnT&&               errorFn) {
+  // Created before the delegate exists, since an already cancelled token
+  // completes the call right away
+  auto call = makeCancellableCall<DelegateT>(token,
+                                             std::forward<SuccessFnT>(successFn),
+                                             std::forward<ErrorFnT>(errorFn));
+  using Call = typename decltype(call)::element_type;
+  return delegate::impl::makeFnDelegate<DelegateT>(
+    [call](typename Call::Success&& success) {
+      call->succeed(std::move(success));
+    },
+    [call](typename Call::Error&& error, cbe::util::Context&& context) {
+      call->fail(std::move(error), std::move(context));
+    });
+}
+
+    } // namespace impl
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Cancellation_h__
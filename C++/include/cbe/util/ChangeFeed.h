@@ -0,0 +1,259 @@
+#ifndef CBE__util__ChangeFeed_h__
+#define CBE__util__ChangeFeed_h__
+
+#include "cbe/delegate/ChangeEvent.h"
+#include "cbe/delegate/ChangeFeedDelegate.h"
+
+#include "cbe/util/Executor.h"
+#include "cbe/util/impl/ChangeEventListener.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <utility>
+
+/**
+ * @file
+ * A change feed with positions, that consumers resume from.
+ *
+ * The service does not number its changes, nor does it replay them, so the
+ * feed is kept by the process: a ChangeFeed registered with
+ * cbe::CloudBackend::addListener() numbers the changes as they are received,
+ * and retains the latest ones for the consumers that fall behind, reconnect
+ * or restart. Changes made while no session of the process was listening
+ * cannot be recovered; the consumer resuming across them, e.g., after a
+ * restart of the process, is told so by ChangeFeedDelegate::onFeedGap().
+ */
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Tuning of a ChangeFeed.
+ */
+struct ChangeFeedOptions {
+  /**
+   * Number of the latest events retained for replay. A consumer resuming
+   * from further back has to re-synchronize.
+   */
+  std::size_t retention = 100000;
+  /**
+   * Executor the events are delivered on, one call at a time per
+   * subscription. If empty, a thread dedicated to the feed is used.
+   */
+  ExecutorPtr executor{};
+}; // struct ChangeFeedOptions
+
+    namespace impl {
+
+class FeedState {
+public:
+  using Id = std::uint64_t;
+
+  explicit FeedState(ChangeFeedOptions options)
+    : options{std::move(options)},
+      executor{this->options.executor
+                 ? this->options.executor
+                 : std::make_shared<ThreadPoolExecutor>(1)},
+      epoch{newEpoch()} {}
+
+  FeedState(const FeedState&) = delete;
+  FeedState& operator=(const FeedState&) = delete;
+
+  void append(delegate::ChangeEvent&& event) {
+    std::lock_guard<std::mutex> lock{mutex};
+    delegate::FeedEvent feedEvent{};
+    feedEvent.position = delegate::FeedPosition{epoch, ++sequence};
+    feedEvent.event = std::move(event);
+    for (auto& subscriber : subscribers) {
+      post(subscriber.second, delegate::FeedEvents{feedEvent});
+    }
+    if (options.retention) {
+      if (retained.size() == options.retention) {
+        retained.pop_front();
+      }
+      retained.push_back(std::move(feedEvent));
+    }
+  }
+
+  // Replays the events after from, or reports the gap, then goes live; the
+  // mutex is held throughout so that no event is missed or delivered twice
+  Id subscribe(delegate::ChangeFeedDelegatePtr delegate,
+               const delegate::FeedPosition*   from) {
+    std::lock_guard<std::mutex> lock{mutex};
+    Subscriber subscriber{std::move(delegate),
+                          std::make_shared<Strand>(executor)};
+    if (from && (from->epoch != epoch || from->sequence != sequence)) {
+      const auto oldest = retained.empty()
+                            ? sequence + 1
+                            : retained.front().position.sequence;
+      if (from->epoch != epoch || from->sequence > sequence ||
+          from->sequence + 1 < oldest) {
+        const delegate::FeedPosition resumedAt{epoch, sequence};
+        const auto delegate = subscriber.delegate;
+        subscriber.strand->post([delegate, resumedAt]() {
+          delegate->onFeedGap(resumedAt);
+        });
+      } else {
+        delegate::FeedEvents missed(
+          retained.begin() + static_cast<std::ptrdiff_t>(
+                               from->sequence + 1 - oldest),
+          retained.end());
+        post(subscriber, std::move(missed));
+      }
+    }
+    const auto id = ++lastId;
+    subscribers.emplace(id, std::move(subscriber));
+    return id;
+  }
+
+  void unsubscribe(Id id) {
+    std::lock_guard<std::mutex> lock{mutex};
+    subscribers.erase(id);
+  }
+
+  delegate::FeedPosition position() {
+    std::lock_guard<std::mutex> lock{mutex};
+    return delegate::FeedPosition{epoch, sequence};
+  }
+
+private:
+  struct Subscriber {
+    delegate::ChangeFeedDelegatePtr delegate;
+    std::shared_ptr<Strand>         strand;
+  }; // struct Subscriber
+
+  static std::uint64_t newEpoch() {
+    std::random_device device{};
+    const auto now = static_cast<std::uint64_t>(
+      std::chrono::system_clock::now().time_since_epoch().count());
+    return ((static_cast<std::uint64_t>(device()) << 32) ^ now) | 1;
+  }
+
+  static void post(const Subscriber&      subscriber,
+                   delegate::FeedEvents&& events) {
+    const auto posted = std::make_shared<delegate::FeedEvents>(
+                                                            std::move(events));
+    const auto delegate = subscriber.delegate;
+    subscriber.strand->post([delegate, posted]() {
+      delegate->onFeedEvents(std::move(*posted));
+    });
+  }
+
+  const ChangeFeedOptions         options;
+  const ExecutorPtr               executor;
+  const std::uint64_t             epoch;
+  std::mutex                      mutex{};
+  std::uint64_t                   sequence{};
+  std::deque<delegate::FeedEvent> retained{};
+  std::map<Id, Subscriber>        subscribers{};
+  Id                              lastId{};
+}; // class FeedState
+
+    } // namespace impl
+
+/**
+ * @brief Ends a subscription to a ChangeFeed when destroyed or reset.
+ *
+ * Events already posted to the subscriber may still be delivered.
+ */
+class FeedSubscription {
+public:
+  FeedSubscription() = default;
+  FeedSubscription(std::weak_ptr<impl::FeedState> state, impl::FeedState::Id id)
+    : state{std::move(state)}, id{id} {}
+
+  FeedSubscription(FeedSubscription&& other) noexcept
+    : state{std::move(other.state)}, id{other.id} {
+    other.state.reset();
+  }
+  FeedSubscription& operator=(FeedSubscription&& other) noexcept {
+    if (this != &other) {
+      reset();
+      state = std::move(other.state);
+      id = other.id;
+      other.state.reset();
+    }
+    return *this;
+  }
+  FeedSubscription(const FeedSubscription&) = delete;
+  FeedSubscription& operator=(const FeedSubscription&) = delete;
+
+  ~FeedSubscription() { reset(); }
+
+  void reset() {
+    if (auto locked = state.lock()) {
+      locked->unsubscribe(id);
+    }
+    state.reset();
+  }
+
+private:
+  std::weak_ptr<impl::FeedState>  state{};
+  impl::FeedState::Id             id{};
+}; // class FeedSubscription
+
+/**
+ * @brief Listener numbering the remote changes, and feeding them to any number
+ *        of subscribers, each resuming from a position of its own.
+ *
+ * Pass the ChangeFeed into cbe::CloudBackend::addListener(), possibly layered
+ * under a FilteredListener, and subscribe() the consumers. A consumer stores
+ * the FeedEvent::position of the last event it has processed, and subscribes
+ * with it on reconnect; the missed events are then replayed in one call.
+ */
+class ChangeFeed final : public impl::ChangeEventListener {
+public:
+  explicit ChangeFeed(ChangeFeedOptions options)
+    : state{std::make_shared<impl::FeedState>(std::move(options))} {}
+  /**
+   * Same as ChangeFeed(ChangeFeedOptions), with the default options.
+   */
+  ChangeFeed() : ChangeFeed{ChangeFeedOptions{}} {}
+
+  ChangeFeed(const ChangeFeed&) = delete;
+  ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+  /**
+   * Subscribes \p delegate to the events after \p from.
+   *
+   * The retained events after \p from are replayed at once, or
+   * delegate::ChangeFeedDelegate::onFeedGap() is called if some are no longer
+   * retained. The subscription then continues with the new events.
+   */
+  FeedSubscription subscribe(delegate::ChangeFeedDelegatePtr delegate,
+                             delegate::FeedPosition          from) {
+    return FeedSubscription{state, state->subscribe(std::move(delegate),
+                                                    &from)};
+  }
+  /**
+   * Subscribes \p delegate to the events after the current position().
+   */
+  FeedSubscription subscribe(delegate::ChangeFeedDelegatePtr delegate) {
+    return FeedSubscription{state, state->subscribe(std::move(delegate),
+                                                    nullptr)};
+  }
+
+  /**
+   * @return The position of the last event received.
+   */
+  delegate::FeedPosition position() const { return state->position(); }
+
+protected:
+  void onChange(ChangeEvent&& event) override {
+    state->append(std::move(event));
+  }
+
+private:
+  std::shared_ptr<impl::FeedState> state;
+}; // class ChangeFeed
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__ChangeFeed_h__
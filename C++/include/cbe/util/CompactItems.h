@@ -0,0 +1,534 @@
+#ifndef CBE__util__CompactItems_h__
+#define CBE__util__CompactItems_h__
+
+#include "cbe/CloudBackend.h"
+#include "cbe/Item.h"
+#include "cbe/Object.h"
+#include "cbe/QueryResult.h"
+#include "cbe/Types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ * A compact, read-only representation of large sets of items.
+ *
+ * A cbe::Item is a handle to an object of the SDK that holds its strings and
+ * maps one by one. CompactItems copies the fields of the items into a
+ * columnar layout, interning the strings that repeat across items, so that
+ * the items, e.g., of a million item cbe::QueryResult, can be held at a
+ * fraction of the memory once the result itself has been released.
+ *
+ * The strings are read as std::string_view, and the items can be iterated as
+ * ItemView, so that sorting and filtering them does not allocate.
+ *
+ * All the memory of a CompactItems is taken from the
+ * std::pmr::memory_resource of CompactItemsOptions::memoryResource, e.g., a
+ * std::pmr::monotonic_buffer_resource per result, so that a page of items is
+ * held in a few contiguous blocks, released together.
+ *
+ * Requires C++17.
+ */
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief What CompactItems copies besides the scalar and string fields.
+ */
+struct CompactItemsOptions {
+  /** Copies the ACL maps, interned, see CompactItems::aclMap(). */
+  bool aclMaps = true;
+  /** Copies the share ids of the items having any, see CompactItems::shareIds(). */
+  bool shareIds = false;
+  /**
+   * The memory the store is allocated from, e.g., a
+   * std::pmr::monotonic_buffer_resource, or a resource of a jemalloc or
+   * mimalloc arena. Must outlive the store. If null, the default resource.
+   */
+  std::pmr::memory_resource* memoryResource = nullptr;
+}; // struct CompactItemsOptions
+
+    namespace impl {
+
+/**
+ * @brief Stores each distinct string once, and refers to it by index.
+ */
+class StringPool {
+public:
+  using Index = std::uint32_t;
+
+  explicit StringPool(std::pmr::memory_resource* memoryResource)
+    : strings{memoryResource}, indexes{memoryResource} {
+    intern(std::string_view{}); // Index 0 is the empty string
+  }
+
+  Index intern(std::string_view string) {
+    auto found = indexes.find(string);
+    if (found != indexes.end()) {
+      return found->second;
+    }
+    const auto index = static_cast<Index>(strings.size());
+    strings.emplace_back(string);
+    bytes += strings.back().capacity();
+    indexes.emplace(strings.back(), index); // Deque elements do not move
+    return index;
+  }
+
+  std::string_view operator[](Index index) const { return strings[index]; }
+
+  std::size_t size() const { return strings.size(); }
+
+  std::size_t memory() const {
+    return bytes + strings.size() * (sizeof(std::pmr::string) +
+                                      sizeof(std::string_view) +
+                                      sizeof(Index) + 2 * sizeof(void*));
+  }
+
+private:
+  std::pmr::deque<std::pmr::string>                 strings;
+  std::pmr::unordered_map<std::string_view, Index>  indexes;
+  std::size_t                                       bytes{};
+}; // class StringPool
+
+    } // namespace impl
+
+class CompactItems;
+
+/**
+ * @brief A borrowed view of one item of a CompactItems, with the accessors
+ *        of cbe::Item and cbe::Object, the strings returned as views.
+ *
+ * Valid as long as the CompactItems is, and not appended to.
+ */
+class ItemView {
+public:
+  using Index = std::size_t;
+
+  ItemView(const CompactItems& items, Index index)
+    : items{&items}, at{index} {}
+
+  /** The index of the item in the CompactItems. */
+  Index index() const { return at; }
+
+  cbe::ItemId       id() const;
+  cbe::ContainerId  parentId() const;
+  cbe::UserId       ownerId() const;
+  cbe::Date         created() const;
+  cbe::Date         updated() const;
+  cbe::ItemType     type() const;
+  std::string_view  name() const;
+  std::string_view  pathDirectory() const;
+  std::string_view  pathLeaf() const;
+  std::string       path() const;
+  std::string_view  username() const;
+  std::string_view  description() const;
+  std::string_view  aclTag() const;
+  std::string_view  mimeType() const;
+  std::uint64_t     length() const;
+  cbe::AclMap       aclMap() const;
+
+private:
+  const CompactItems* items;
+  Index               at;
+}; // class ItemView
+
+/**
+ * @brief The fields of a sequence of items, in a compact, columnar layout.
+ *
+ * Per item, a fixed record of a few tens of bytes is kept, plus its name:
+ * <ul>
+ *   <li> owner user names, descriptions and ACL tags are interned, as are
+ *        the ACL maps, stored flat,
+ *   <li> paths are split into the directory part, interned, and the last
+ *        component,
+ *   <li> the names and last path components share one character buffer,
+ *   <li> share ids are kept in a flat table, for the items having any.
+ * </ul>
+ * The maps are materialized on request only. Items are addressed by their
+ * index, in the order they were appended.
+ */
+class CompactItems {
+public:
+  using Index     = std::size_t;
+  using AclEntry  = cbe::AclMap::value_type;
+
+  /**
+   * @brief Iterates the items as ItemView, in the order they were appended.
+   */
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = ItemView;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = void;
+    using reference         = ItemView;
+
+    const_iterator(const CompactItems& items, Index index)
+      : items{&items}, at{index} {}
+
+    ItemView operator*() const { return ItemView{*items, at}; }
+    const_iterator& operator++() {
+      ++at;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto result = *this;
+      ++at;
+      return result;
+    }
+    bool operator==(const const_iterator& other) const {
+      return at == other.at;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return at != other.at;
+    }
+
+  private:
+    const CompactItems* items;
+    Index               at;
+  }; // class const_iterator
+
+  explicit CompactItems(CompactItemsOptions options)
+    : options{options},
+      memoryResource{options.memoryResource
+                       ? options.memoryResource
+                       : std::pmr::get_default_resource()},
+      records{memoryResource}, chars{memoryResource}, pool{memoryResource},
+      acls{memoryResource}, aclIndexes{memoryResource},
+      shares{memoryResource}, byId{memoryResource} {
+    acls.emplace_back(); // Index 0 is the empty ACL
+  }
+  /** Same as CompactItems(CompactItemsOptions), with the default options. */
+  CompactItems() : CompactItems{CompactItemsOptions{}} {}
+
+  // The members refer to each other's memory resource
+  CompactItems(const CompactItems&) = delete;
+  CompactItems& operator=(const CompactItems&) = delete;
+
+  /**
+   * Copies the items of \p queryResult.
+   */
+  CompactItems(const cbe::QueryResult& queryResult, CompactItemsOptions options)
+    : CompactItems{options} {
+    append(queryResult);
+  }
+  /**
+   * Same as CompactItems(const cbe::QueryResult&,CompactItemsOptions), with
+   * the default options.
+   */
+  explicit CompactItems(const cbe::QueryResult& queryResult)
+    : CompactItems{queryResult, CompactItemsOptions{}} {}
+
+  void append(const cbe::QueryResult& queryResult) {
+    auto items = queryResult.getItemsSnapshot();
+    // Grown geometrically, as appending page by page would otherwise copy
+    // all the records per page, and leave each old copy allocated from a
+    // resource that does not free, e.g., a monotonic_buffer_resource
+    const auto needed = records.size() + items.size();
+    if (needed > records.capacity()) {
+      records.reserve(std::max(needed, 2 * records.capacity()));
+    }
+    for (const auto& item : items) {
+      append(item);
+    }
+  }
+
+  /**
+   * Copies \p item.
+   *
+   * @throws std::length_error The names and last path components of the items
+   *        would take more than 4 GiB.
+   */
+  void append(const cbe::Item& item) {
+    Record record{};
+    record.id = item.id();
+    record.parentId = item.parentId();
+    record.ownerId = item.ownerId();
+    record.created = item.created();
+    record.updated = item.updated();
+    record.type = item.type();
+    if (record.type == cbe::ItemType::Object) {
+      const auto object = cbe::CloudBackend::castObject(item);
+      record.length = object.length();
+      record.mimeType = pool.intern(object.getMimeType());
+    }
+    record.name = text(item.name());
+    auto path = item.path();
+    const auto split = path.rfind('/');
+    const auto leafStart = split == std::string::npos ? 0 : split + 1;
+    record.pathLeaf = text(path.substr(leafStart));
+    path.resize(leafStart);
+    record.pathDirectory = pool.intern(path);
+    record.username = pool.intern(item.username());
+    record.description = pool.intern(item.description());
+    record.aclTag = pool.intern(item.aclTag());
+    if (options.aclMaps) {
+      record.acl = internAcl(item.aclMap());
+    }
+    if (options.shareIds) {
+      // The items being appended in order, the entries stay sorted by index
+      for (const auto& share : item.getShareIds()) {
+        for (const auto& data : share.second) {
+          shares.push_back(ShareEntry{records.size(), share.first, data.id,
+                                      data.isUserId});
+        }
+      }
+    }
+    records.push_back(record);
+    // The first of items of the same id is found
+    byId.emplace(record.id, records.size() - 1);
+  }
+
+  Index size() const { return records.size(); }
+  bool  empty() const { return records.empty(); }
+
+  ItemView        operator[](Index index) const { return ItemView{*this, index}; }
+  const_iterator  begin() const { return const_iterator{*this, 0}; }
+  const_iterator  end() const { return const_iterator{*this, records.size()}; }
+
+  cbe::ItemId       id(Index index) const { return records[index].id; }
+  cbe::ContainerId  parentId(Index index) const {
+    return records[index].parentId;
+  }
+  cbe::UserId       ownerId(Index index) const {
+    return records[index].ownerId;
+  }
+  cbe::Date         created(Index index) const {
+    return records[index].created;
+  }
+  cbe::Date         updated(Index index) const {
+    return records[index].updated;
+  }
+  cbe::ItemType     type(Index index) const { return records[index].type; }
+
+  /**
+   * The string accessors return views into the store, valid until the next
+   * append().
+   */
+  std::string_view name(Index index) const {
+    return view(records[index].name);
+  }
+  /** The directory part of the path, up to and including the last '/'. */
+  std::string_view pathDirectory(Index index) const {
+    return pool[records[index].pathDirectory];
+  }
+  /** The last component of the path. */
+  std::string_view pathLeaf(Index index) const {
+    return view(records[index].pathLeaf);
+  }
+  std::string path(Index index) const {
+    std::string result{pathDirectory(index)};
+    result.append(pathLeaf(index));
+    return result;
+  }
+  std::string_view username(Index index) const {
+    return pool[records[index].username];
+  }
+  std::string_view description(Index index) const {
+    return pool[records[index].description];
+  }
+  std::string_view aclTag(Index index) const {
+    return pool[records[index].aclTag];
+  }
+  /** The MIME type of an object, empty for a container. */
+  std::string_view mimeType(Index index) const {
+    return pool[records[index].mimeType];
+  }
+  /** The length of an object, 0 for a container. */
+  std::uint64_t length(Index index) const { return records[index].length; }
+
+  /**
+   * @return The ACL entries of the item, sorted by cbe::AclGroupId, empty
+   *         unless CompactItemsOptions::aclMaps.
+   */
+  const std::pmr::vector<AclEntry>& aclEntries(Index index) const {
+    return acls[records[index].acl];
+  }
+  /** The ACL map of the item, materialized. */
+  cbe::AclMap aclMap(Index index) const {
+    const auto& entries = aclEntries(index);
+    return cbe::AclMap(entries.begin(), entries.end());
+  }
+  /** The share ids of the item, empty unless CompactItemsOptions::shareIds. */
+  cbe::ShareIds shareIds(Index index) const {
+    cbe::ShareIds result{};
+    auto entry = std::lower_bound(shares.begin(), shares.end(), index,
+                                  [](const ShareEntry& entry, Index index) {
+                                    return entry.index < index;
+                                  });
+    for (; entry != shares.end() && entry->index == index; ++entry) {
+      result[entry->shareId].emplace_back(entry->id, entry->isUserId);
+    }
+    return result;
+  }
+
+  /**
+   * @return The index of the first item of id \p itemId, or size() if none.
+   */
+  Index find(cbe::ItemId itemId) const {
+    auto found = byId.find(itemId);
+    return found == byId.end() ? records.size() : found->second;
+  }
+
+  /**
+   * @return An estimate of the memory held, in bytes.
+   */
+  std::size_t memory() const {
+    std::size_t aclBytes{};
+    for (const auto& acl : acls) {
+      aclBytes += sizeof(acl) + acl.capacity() * sizeof(AclEntry);
+    }
+    return records.capacity() * sizeof(Record) + chars.capacity() +
+           pool.memory() + aclBytes +
+           aclIndexes.size() * (sizeof(std::size_t) + sizeof(AclIndex) +
+                                2 * sizeof(void*)) +
+           shares.capacity() * sizeof(ShareEntry) +
+           byId.size() * (sizeof(cbe::ItemId) + sizeof(Index) +
+                          2 * sizeof(void*));
+  }
+
+private:
+  using AclIndex = std::uint32_t;
+
+  struct Span {
+    std::uint32_t offset;
+    std::uint32_t length;
+  }; // struct Span
+
+  struct Record {
+    cbe::ItemId               id;
+    cbe::ContainerId          parentId;
+    cbe::UserId               ownerId;
+    cbe::Date                 created;
+    cbe::Date                 updated;
+    std::uint64_t             length;
+    Span                      name;
+    Span                      pathLeaf;
+    impl::StringPool::Index   pathDirectory;
+    impl::StringPool::Index   username;
+    impl::StringPool::Index   description;
+    impl::StringPool::Index   aclTag;
+    impl::StringPool::Index   mimeType;
+    AclIndex                  acl;
+    cbe::ItemType             type;
+  }; // struct Record
+
+  // One cbe::ShareData of a share of an item
+  struct ShareEntry {
+    Index         index;
+    cbe::ShareId  shareId;
+    std::uint64_t id;
+    bool          isUserId;
+  }; // struct ShareEntry
+
+  // The offsets being 32 bits, the names and last path components of the
+  // items may take up to 4 GiB in all
+  Span text(const std::string& string) {
+    if (string.size() > std::numeric_limits<std::uint32_t>::max() -
+                                                              chars.size()) {
+      throw std::length_error{"cbe::util::CompactItems: more than 4 GiB of "
+                              "names"};
+    }
+    const Span span{static_cast<std::uint32_t>(chars.size()),
+                    static_cast<std::uint32_t>(string.size())};
+    chars.append(string);
+    return span;
+  }
+
+  std::string_view view(Span span) const {
+    return std::string_view{chars.data() + span.offset, span.length};
+  }
+
+  static std::size_t hash(const cbe::AclMap& aclMap) {
+    std::size_t result = aclMap.size();
+    for (const auto& entry : aclMap) {
+      for (auto value : {static_cast<std::uint64_t>(entry.first),
+                         static_cast<std::uint64_t>(entry.second.first),
+                         static_cast<std::uint64_t>(entry.second.second)}) {
+        result ^= std::hash<std::uint64_t>{}(value) + 0x9e3779b97f4a7c15ULL +
+                  (result << 6) + (result >> 2);
+      }
+    }
+    return result;
+  }
+
+  AclIndex internAcl(const cbe::AclMap& aclMap) {
+    if (aclMap.empty()) {
+      return 0;
+    }
+    const auto key = hash(aclMap);
+    auto range = aclIndexes.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+      const auto& entries = acls[it->second];
+      if (std::equal(entries.begin(), entries.end(),
+                     aclMap.begin(), aclMap.end())) {
+        return it->second;
+      }
+    }
+    const auto index = static_cast<AclIndex>(acls.size());
+    acls.emplace_back(aclMap.begin(), aclMap.end());
+    aclIndexes.emplace(key, index);
+    return index;
+  }
+
+  const CompactItemsOptions                             options;
+  std::pmr::memory_resource* const                      memoryResource;
+  std::pmr::vector<Record>                              records;
+  std::pmr::string                                      chars;
+  impl::StringPool                                      pool;
+  std::pmr::vector<std::pmr::vector<AclEntry>>          acls;
+  // The ACLs by hash of their entries
+  std::pmr::unordered_multimap<std::size_t, AclIndex>   aclIndexes;
+  // The share ids of the items, sorted by index
+  std::pmr::vector<ShareEntry>                          shares;
+  std::pmr::unordered_map<cbe::ItemId, Index>           byId;
+}; // class CompactItems
+
+inline cbe::ItemId ItemView::id() const { return items->id(at); }
+inline cbe::ContainerId ItemView::parentId() const {
+  return items->parentId(at);
+}
+inline cbe::UserId ItemView::ownerId() const { return items->ownerId(at); }
+inline cbe::Date ItemView::created() const { return items->created(at); }
+inline cbe::Date ItemView::updated() const { return items->updated(at); }
+inline cbe::ItemType ItemView::type() const { return items->type(at); }
+inline std::string_view ItemView::name() const { return items->name(at); }
+inline std::string_view ItemView::pathDirectory() const {
+  return items->pathDirectory(at);
+}
+inline std::string_view ItemView::pathLeaf() const {
+  return items->pathLeaf(at);
+}
+inline std::string ItemView::path() const { return items->path(at); }
+inline std::string_view ItemView::username() const {
+  return items->username(at);
+}
+inline std::string_view ItemView::description() const {
+  return items->description(at);
+}
+inline std::string_view ItemView::aclTag() const { return items->aclTag(at); }
+inline std::string_view ItemView::mimeType() const {
+  return items->mimeType(at);
+}
+inline std::uint64_t ItemView::length() const { return items->length(at); }
+inline cbe::AclMap ItemView::aclMap() const { return items->aclMap(at); }
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__CompactItems_h__
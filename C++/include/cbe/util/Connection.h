@@ -0,0 +1,238 @@
+#ifndef CBE__util__Connection_h__
+#define CBE__util__Connection_h__
+
+#include "cbe/Account.h"
+#include "cbe/CloudBackend.h"
+#include "cbe/Container.h"
+#include "cbe/Filter.h"
+#include "cbe/QueryChain.h"
+#include "cbe/QueryResult.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/QueryDelegate.h"
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Context.h"
+#include "cbe/util/Executor.h"
+#include "cbe/util/impl/SyncSignal.h"
+#include "cbe/util/impl/Timer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+/**
+ * @file
+ * Connection warm-up for a cbe::CloudBackend session.
+ *
+ * The connections of a session are owned by the SDK library, and are neither
+ * visible nor configurable through the API. What the application can do is
+ * to pay the connection set-up, including the TLS handshake, ahead of a burst
+ * rather than during it, and to keep the connections from idling out between
+ * bursts.
+ */
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+class PrewarmJob {
+public:
+  using DoneFn = std::function<void(std::size_t)>;
+
+  PrewarmJob(std::size_t requests, DoneFn done)
+    : remaining{requests}, done{std::move(done)} {}
+
+  void start(cbe::CloudBackend cloudBackend, std::size_t requests,
+             const std::shared_ptr<PrewarmJob>& self) {
+    const auto rootId = cloudBackend.account().rootContainer().id();
+    for (std::size_t i = 0; i < requests; ++i) {
+      // A minimal listing that bypasses the cache, hence reaches the service
+      cloudBackend.query(
+        rootId, cbe::Filter{}.setCount(1).setByPassCache(true),
+        delegate::impl::makeFnDelegate<delegate::QueryDelegate>(
+          [self](cbe::QueryResult&&) { self->complete(true); },
+          [self](delegate::QueryError&&, cbe::util::Context&&) {
+            self->complete(false);
+          }));
+    }
+  }
+
+private:
+  void complete(bool success) {
+    if (success) {
+      ++succeeded;
+    }
+    if (--remaining == 0) {
+      done(succeeded.load());
+    }
+  }
+
+  std::atomic<std::size_t>  remaining;
+  std::atomic<std::size_t>  succeeded{};
+  DoneFn                    done;
+}; // class PrewarmJob
+
+    } // namespace impl
+
+/**
+ * @brief Sets up the connections of a session ahead of a burst of calls.
+ *
+ * Makes \p requests concurrent, minimal requests to the service, so that the
+ * SDK opens its connections, including their TLS handshakes, now rather than
+ * during the burst that follows.
+ *
+ * @param cloudBackend  The session to warm up.
+ * @param requests      Number of concurrent requests, i.e., the number of
+ *                      connections expected to be used concurrently.
+ * @param done          Invoked as <code>done(std::size_t succeeded)</code>
+ *                      once all requests have returned.
+ */
+inline void prewarm(cbe::CloudBackend                     cloudBackend,
+                    std::size_t                           requests,
+                    std::function<void(std::size_t)>      done) {
+  if (!requests) {
+    done(0);
+    return;
+  }
+  auto job = std::make_shared<impl::PrewarmJob>(requests, std::move(done));
+  job->start(std::move(cloudBackend), requests, job);
+}
+
+#ifndef CBE_NO_SYNC
+/**
+ * @brief Synchronous version of
+ *        prewarm(cbe::CloudBackend,std::size_t,std::function<void(std::size_t)>).
+ *
+ * @return The number of requests that succeeded.
+ */
+inline std::size_t prewarm(cbe::CloudBackend cloudBackend,
+                           std::size_t       requests) {
+  struct Waiter {
+    impl::SyncSignal  signal{};
+    std::size_t       succeeded{};
+  };
+  auto waiter = std::make_shared<Waiter>();
+  prewarm(std::move(cloudBackend), requests, [waiter](std::size_t succeeded) {
+    waiter->succeeded = succeeded;
+    waiter->signal.notify();
+  });
+  waiter->signal.wait();
+  return waiter->succeeded;
+}
+#endif // #ifndef CBE_NO_SYNC
+
+/**
+ * @brief Keeps the connections of a session from idling out, as long as the
+ *        object lives.
+ *
+ * Calls prewarm() every \p interval, which should be shorter than the idle
+ * timeout of the network path, e.g., of a proxy or load balancer. Sessions
+ * with bursty traffic thereby avoid a new TLS handshake per burst.
+ */
+class KeepAlive {
+public:
+  /**
+   * @param executor  Executor the pings are made on, so that the calls are
+   *                  not made on the timer thread.
+   */
+  KeepAlive(cbe::CloudBackend         cloudBackend,
+            std::chrono::milliseconds interval,
+            std::size_t               connections,
+            ExecutorPtr               executor)
+    : state{std::make_shared<State>(std::move(cloudBackend), interval,
+                                    connections, std::move(executor))} {
+    schedule(state);
+  }
+  /**
+   * Same as KeepAlive(cbe::CloudBackend,std::chrono::milliseconds,std::size_t,ExecutorPtr),
+   * with the executor shared by the SDK headers.
+   */
+  KeepAlive(cbe::CloudBackend         cloudBackend,
+            std::chrono::milliseconds interval,
+            std::size_t               connections)
+    : KeepAlive{std::move(cloudBackend), interval, connections,
+                impl::sharedExecutor()} {}
+  /**
+   * Same as KeepAlive(cbe::CloudBackend,std::chrono::milliseconds,std::size_t),
+   * keeping a single connection alive.
+   */
+  KeepAlive(cbe::CloudBackend cloudBackend, std::chrono::milliseconds interval)
+    : KeepAlive{std::move(cloudBackend), interval, 1} {}
+
+  KeepAlive(const KeepAlive&) = delete;
+  KeepAlive& operator=(const KeepAlive&) = delete;
+
+  ~KeepAlive() {
+    std::lock_guard<std::mutex> lock{state->mutex};
+    state->stopped = true;
+    impl::Timer::instance().unschedule(state->timer);
+  }
+
+private:
+  struct State {
+    State(cbe::CloudBackend         cloudBackend,
+          std::chrono::milliseconds interval,
+          std::size_t               connections,
+          ExecutorPtr               executor)
+      : cloudBackend{std::move(cloudBackend)}, interval{interval},
+        connections{connections}, executor{std::move(executor)} {}
+
+    std::mutex                      mutex{};
+    cbe::CloudBackend               cloudBackend;
+    const std::chrono::milliseconds interval;
+    const std::size_t               connections;
+    const ExecutorPtr               executor;
+    impl::Timer::Id                 timer{};
+    bool                            stopped{};
+  }; // struct State
+
+  // The next ping is scheduled once the previous one has returned, so that a
+  // slow service does not pile up pings
+  static void schedule(const std::shared_ptr<State>& state) {
+    std::weak_ptr<State> weakState = state;
+    std::lock_guard<std::mutex> lock{state->mutex};
+    if (state->stopped) {
+      return;
+    }
+    // The timer thread only hands the ping over to the executor
+    auto executor = state->executor;
+    state->timer = impl::Timer::instance().schedule(
+      impl::Timer::Clock::now() + state->interval,
+      [weakState, executor]() {
+        executor->post([weakState]() { ping(weakState); });
+      });
+  }
+
+  static void ping(const std::weak_ptr<State>& weakState) {
+    auto state = weakState.lock();
+    if (!state) {
+      return;
+    }
+    cbe::CloudBackend cloudBackend{cbe::DefaultCtor{}};
+    {
+      std::lock_guard<std::mutex> lock{state->mutex};
+      if (state->stopped) {
+        return;
+      }
+      cloudBackend = state->cloudBackend;
+    }
+    prewarm(std::move(cloudBackend), state->connections,
+            [weakState](std::size_t) {
+              if (auto state = weakState.lock()) {
+                schedule(state);
+              }
+            });
+  }
+
+  std::shared_ptr<State> state;
+}; // class KeepAlive
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Connection_h__
@@ -0,0 +1,130 @@
+#ifndef CBE__util__Deadline_h__
+#define CBE__util__Deadline_h__
+
+#include "cbe/Types.h"
+
+#include "cbe/delegate/Error.h"
+
+#include "cbe/util/Cancellation.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * Error code reported through the error callback of a delegate whose call did
+ * not complete before its deadline, see withDeadline() and withTimeout().
+ */
+constexpr cbe::ErrorCode deadlineExceededErrorCode = 408;
+
+    namespace impl {
+
+inline std::atomic<std::chrono::milliseconds::rep>& defaultTimeoutMs() {
+  static std::atomic<std::chrono::milliseconds::rep> timeoutMs{0};
+  return timeoutMs;
+}
+
+inline delegate::Error deadlineExceededError(std::string&& message) {
+  return delegate::Error{deadlineExceededErrorCode, "Request Timeout",
+                         std::move(message)};
+}
+
+    } // namespace impl
+
+/**
+ * @brief Creates a token that is cancelled at \p deadline, or when \p parent
+ *        is cancelled, whichever comes first.
+ *
+ * Calls made with the token, see CancellationToken, complete with error code
+ * deadlineExceededErrorCode once the deadline has passed. Passing the same
+ * token into every attempt of a call, e.g., its retries, enforces a single
+ * time budget across all of them.
+ */
+inline CancellationToken withDeadline(const CancellationToken&      parent,
+                                      CancellationSource::Clock::time_point
+                                                                    deadline) {
+  CancellationSource source{parent};
+  source.cancelAt(deadline, impl::deadlineExceededError("Deadline exceeded"));
+  return source.token();
+}
+/**
+ * Same as withDeadline(const CancellationToken&,CancellationSource::Clock::time_point),
+ * but without a parent token.
+ */
+inline CancellationToken withDeadline(CancellationSource::Clock::time_point
+                                                                    deadline) {
+  return withDeadline(CancellationToken{}, deadline);
+}
+
+/**
+ * @brief Creates a token that is cancelled once \p timeout has elapsed from
+ *        now, or when \p parent is cancelled, whichever comes first.
+ *
+ * See withDeadline(const CancellationToken&,CancellationSource::Clock::time_point).
+ *
+ * \par Example
+ * \code {.cpp}
+ * cbe::delegate::QueryDelegate::ErrorInfo error{};
+ * auto result = cbe::util::callSync<cbe::delegate::QueryDelegate>(
+ *                 [&](auto delegate) { container.query(filter, delegate); },
+ *                 cbe::util::withTimeout(std::chrono::seconds{5}),
+ *                 error);
+ * \endcode
+ */
+inline CancellationToken withTimeout(const CancellationToken&  parent,
+                                     std::chrono::milliseconds timeout) {
+  CancellationSource source{parent};
+  source.cancelAt(CancellationSource::Clock::now() + timeout,
+                  impl::deadlineExceededError(
+                    "Timeout of " + std::to_string(timeout.count()) +
+                    " ms exceeded"));
+  return source.token();
+}
+/**
+ * Same as withTimeout(const CancellationToken&,std::chrono::milliseconds),
+ * but without a parent token.
+ */
+inline CancellationToken withTimeout(std::chrono::milliseconds timeout) {
+  return withTimeout(CancellationToken{}, timeout);
+}
+
+/**
+ * @brief Sets the timeout of the calls made without a CancellationToken
+ *        through cbe::delegate::makeDelegate(), callSync() and awaitable().
+ *
+ * Applies to all sessions of the process. Zero, the default, implies no
+ * timeout. Calls made with a token are governed by the token only, use
+ * withTimeout(const CancellationToken&,std::chrono::milliseconds) with
+ * defaultTimeout() to combine the two.
+ */
+inline void setDefaultTimeout(std::chrono::milliseconds timeout) {
+  impl::defaultTimeoutMs().store(timeout.count(), std::memory_order_relaxed);
+}
+
+/**
+ * @return The timeout set through setDefaultTimeout(), zero if none.
+ */
+inline std::chrono::milliseconds defaultTimeout() {
+  return std::chrono::milliseconds{
+                    impl::defaultTimeoutMs().load(std::memory_order_relaxed)};
+}
+
+    namespace impl {
+
+/**
+ * The token of a call made without a CancellationToken: never cancelled,
+ * unless a default timeout is set.
+ */
+inline CancellationToken defaultDeadline() {
+  const auto timeout = defaultTimeout();
+  return timeout.count() > 0 ? withTimeout(timeout) : CancellationToken{};
+}
+
+    } // namespace impl
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Deadline_h__
@@ -0,0 +1,203 @@
+#ifndef CBE__util__Executor_h__
+#define CBE__util__Executor_h__
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Interface of an executor that delegate callbacks can be posted to.
+ *
+ * See cbe::util::onExecutor() in cbe/util/OnExecutor.h.
+ */
+class Executor {
+public:
+  using Task = std::function<void()>;
+
+  /**
+   * Schedules \p task for execution. May be called from any thread, including
+   * from a task running on the executor itself.
+   */
+  virtual void post(Task&& task) = 0;
+
+  virtual ~Executor() = default;
+}; // class Executor
+
+/**
+ * Pointer to Executor that is passed into cbe::util::onExecutor().
+ */
+using ExecutorPtr = std::shared_ptr<Executor>;
+
+/**
+ * @brief Executor that runs each task immediately on the posting thread.
+ *
+ * Posting delegate callbacks to an InlineExecutor is equivalent to not using an
+ * executor at all, i.e., the callbacks run on the SDK thread.
+ */
+class InlineExecutor final : public Executor {
+public:
+  void post(Task&& task) override { task(); }
+}; // class InlineExecutor
+
+/**
+ * @brief Executor running tasks on a fixed number of threads owned by it.
+ *
+ * Tasks posted before destruction are still run; the destructor waits for the
+ * threads to finish them.
+ */
+class ThreadPoolExecutor final : public Executor {
+public:
+  /**
+   * @param threads Number of worker threads, at least one is started.
+   */
+  explicit ThreadPoolExecutor(std::size_t threads)
+    : state{std::make_shared<State>()}, workers{} {
+    if (!threads) {
+      threads = 1;
+    }
+    workers.reserve(threads);
+    const auto shared = state;
+    for (std::size_t index = 0; index < threads; ++index) {
+      workers.emplace_back([shared]() { shared->run(); });
+    }
+  }
+
+  ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+  ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+  ~ThreadPoolExecutor() override {
+    {
+      std::lock_guard<std::mutex> lock{state->mutex};
+      state->stopping = true;
+    }
+    state->conditionVariable.notify_all();
+    for (auto& worker : workers) {
+      // The last reference may be released by a task on one of the workers
+      if (worker.get_id() == std::this_thread::get_id()) {
+        worker.detach();
+      } else {
+        worker.join();
+      }
+    }
+  }
+
+  void post(Task&& task) override {
+    {
+      std::lock_guard<std::mutex> lock{state->mutex};
+      state->tasks.push_back(std::move(task));
+    }
+    state->conditionVariable.notify_one();
+  }
+
+private:
+  struct State {
+    std::mutex              mutex{};
+    std::condition_variable conditionVariable{};
+    std::deque<Task>        tasks{};
+    bool                    stopping{};
+
+    void run() {
+      std::unique_lock<std::mutex> lock{mutex};
+      for (;;) {
+        conditionVariable.wait(lock, [this] {
+          return stopping || !tasks.empty();
+        });
+        if (tasks.empty()) {
+          return; // Stopping and drained
+        }
+        auto task = std::move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+      }
+    }
+  }; // struct State
+
+  std::shared_ptr<State>    state;
+  std::vector<std::thread>  workers;
+}; // class ThreadPoolExecutor
+
+/**
+ * @brief Executor that runs its tasks one at a time, in the order they were
+ *        posted, on an underlying executor.
+ *
+ * Typically layered on a ThreadPoolExecutor to get the callbacks of one
+ * delegate, or listener, serialized without dedicating a thread to them.
+ */
+class Strand final : public Executor {
+public:
+  /**
+   * @param executor The executor the tasks are run on.
+   */
+  explicit Strand(ExecutorPtr executor)
+    : state{std::make_shared<State>(std::move(executor))} {}
+
+  void post(Task&& task) override {
+    {
+      std::lock_guard<std::mutex> lock{state->mutex};
+      state->tasks.push_back(std::move(task));
+      if (state->running) {
+        return;
+      }
+      state->running = true;
+    }
+    auto state = this->state;
+    state->executor->post([state]() { state->run(); });
+  }
+
+private:
+  struct State {
+    explicit State(ExecutorPtr executor) : executor{std::move(executor)} {}
+
+    ExecutorPtr       executor;
+    std::mutex        mutex{};
+    std::deque<Task>  tasks{};
+    bool              running{};
+
+    void run() {
+      std::unique_lock<std::mutex> lock{mutex};
+      while (!tasks.empty()) {
+        auto task = std::move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+      }
+      running = false;
+    }
+  }; // struct State
+
+  std::shared_ptr<State> state;
+}; // class Strand
+
+    namespace impl {
+
+/**
+ * @return The executor the util headers post work due on the Timer to, e.g.,
+ *         retries, unless given one; as the Timer, its threads live until the
+ *         process exits.
+ */
+inline const ExecutorPtr& sharedExecutor() {
+  static const ExecutorPtr* const executor = new ExecutorPtr{
+    std::make_shared<ThreadPoolExecutor>(
+      std::max(2u, std::thread::hardware_concurrency()))};
+  return *executor;
+}
+
+    } // namespace impl
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Executor_h__
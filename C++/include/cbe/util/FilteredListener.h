@@ -0,0 +1,223 @@
+#ifndef CBE__util__FilteredListener_h__
+#define CBE__util__FilteredListener_h__
+
+#include "cbe/Container.h"
+#include "cbe/Item.h"
+#include "cbe/Object.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/ChangeEvent.h"
+#include "cbe/delegate/CloudBackendListenerDelegate.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+/**
+ * @file
+ * Listener registration scoped to containers, item types and kinds of change.
+ *
+ * The service sends a session the changes of everything the account can see;
+ * the subscription cannot be narrowed through the API. A FilteredListener
+ * drops the changes out of scope on the SDK thread, as they arrive, before
+ * any Object or Container is handed to the application's listener, or posted
+ * to an executor or batch.
+ */
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief The scope of a FilteredListener.
+ */
+struct ListenerFilter {
+  /**
+   * Containers whose items are of interest, i.e., the changes of items whose
+   * parent, or parent before a move, is one of these pass. Empty implies all
+   * containers.
+   */
+  std::set<cbe::ContainerId>  containers{};
+  /**
+   * Extends the scope to the subtrees of #containers: containers added to, or
+   * moved into, the scope are followed, and those removed, or moved out, are
+   * no longer. Containers that already exist below #containers when the
+   * listener is added must be listed in #containers too.
+   */
+  bool                        subtrees = false;
+  /** Types of items whose changes pass. */
+  std::set<cbe::ItemType>     itemTypes{cbe::ItemType::Object,
+                                        cbe::ItemType::Container};
+  /** Bitwise or of the delegate::ChangeEvent::Kind values that pass. */
+  std::uint8_t                kinds = delegate::ChangeEvent::Added   |
+                                      delegate::ChangeEvent::Moved   |
+                                      delegate::ChangeEvent::Renamed |
+                                      delegate::ChangeEvent::Removed;
+  /**
+   * A removal carries the id of the item only, not its parent, so with
+   * #containers set it cannot be scoped from the change itself. By default,
+   * every removal of the account passes, wherever the item was. If \c false,
+   * only the removals of items seen in scope since the listener was added
+   * pass, at the cost of remembering the ids of those items.
+   */
+  bool                        unscopedRemovals = true;
+}; // struct ListenerFilter
+
+/**
+ * @brief Listener passing the remote changes within the scope of a
+ *        ListenerFilter on to another listener.
+ *
+ * Can be layered on any listener, e.g., on a BatchListener or an
+ * onExecutor() listener, so that the changes out of scope never reach them.
+ */
+class FilteredListener final : public delegate::CloudBackendListenerDelegate {
+public:
+  using ChangeEvent = delegate::ChangeEvent;
+
+  FilteredListener(ListenerFilter                             filter,
+                   delegate::CloudBackendListenerDelegatePtr  listener)
+    : filter{std::move(filter)}, listener{std::move(listener)} {}
+
+  void onRemoteObjectAdded(cbe::Object&& object) override {
+    if (changed(ChangeEvent::Added, cbe::ItemType::Object, object)) {
+      listener->onRemoteObjectAdded(std::move(object));
+    }
+  }
+  void onRemoteObjectMoved(cbe::Object&& object) override {
+    if (changed(ChangeEvent::Moved, cbe::ItemType::Object, object)) {
+      listener->onRemoteObjectMoved(std::move(object));
+    }
+  }
+  void onRemoteObjectRemoved(cbe::ItemId objectId, std::string name) override {
+    if (removed(cbe::ItemType::Object, objectId)) {
+      listener->onRemoteObjectRemoved(objectId, std::move(name));
+    }
+  }
+  void onRemoteObjectRenamed(cbe::Object&& object) override {
+    if (changed(ChangeEvent::Renamed, cbe::ItemType::Object, object)) {
+      listener->onRemoteObjectRenamed(std::move(object));
+    }
+  }
+  void onRemoteContainerAdded(cbe::Container&& container) override {
+    if (changed(ChangeEvent::Added, cbe::ItemType::Container, container)) {
+      listener->onRemoteContainerAdded(std::move(container));
+    }
+  }
+  void onRemoteContainerMoved(cbe::Container&& container) override {
+    if (changed(ChangeEvent::Moved, cbe::ItemType::Container, container)) {
+      listener->onRemoteContainerMoved(std::move(container));
+    }
+  }
+  void onRemoteContainerRemoved(cbe::ItemId containerId,
+                                std::string name) override {
+    if (removed(cbe::ItemType::Container, containerId)) {
+      listener->onRemoteContainerRemoved(containerId, std::move(name));
+    }
+  }
+  void onRemoteContainerRenamed(cbe::Container&& container) override {
+    if (changed(ChangeEvent::Renamed, cbe::ItemType::Container, container)) {
+      listener->onRemoteContainerRenamed(std::move(container));
+    }
+  }
+
+private:
+  using Key = std::pair<cbe::ItemType, cbe::ItemId>;
+
+  bool passes(ChangeEvent::Kind kind, cbe::ItemType itemType) const {
+    return (filter.kinds & kind) && filter.itemTypes.count(itemType);
+  }
+
+  bool scoped() const { return !filter.containers.empty(); }
+
+  bool inScope(cbe::ContainerId containerId) const {
+    return filter.containers.count(containerId) ||
+           followed.count(containerId);
+  }
+
+  bool changed(ChangeEvent::Kind  kind,
+               cbe::ItemType      itemType,
+               const cbe::Item&   item) {
+    if (!scoped()) {
+      return passes(kind, itemType);
+    }
+    const auto parentId = item.parentId();
+    std::lock_guard<std::mutex> lock{mutex};
+    // The scope is tracked whatever the kinds and types passing
+    if (inScope(parentId)) {
+      if (!filter.unscopedRemovals) {
+        known.insert(Key{itemType, item.id()});
+      }
+      if (filter.subtrees && itemType == cbe::ItemType::Container) {
+        followed[item.id()] = parentId;
+      }
+      return passes(kind, itemType);
+    }
+    // Moved out of the scope
+    const bool movedOut = kind == ChangeEvent::Moved &&
+                          inScope(item.oldParentId());
+    leave(itemType, item.id());
+    return movedOut && passes(kind, itemType);
+  }
+
+  bool removed(cbe::ItemType itemType, cbe::ItemId itemId) {
+    if (!scoped()) {
+      return passes(ChangeEvent::Removed, itemType);
+    }
+    std::lock_guard<std::mutex> lock{mutex};
+    const bool wasInScope = known.count(Key{itemType, itemId}) != 0;
+    leave(itemType, itemId);
+    return (wasInScope || filter.unscopedRemovals) &&
+           passes(ChangeEvent::Removed, itemType);
+  }
+
+  // The item is no longer in scope, nor is the subtree of a container
+  void leave(cbe::ItemType itemType, cbe::ItemId itemId) {
+    known.erase(Key{itemType, itemId});
+    if (itemType != cbe::ItemType::Container || !followed.erase(itemId)) {
+      return;
+    }
+    for (bool pruned = true; pruned;) {
+      pruned = false;
+      for (auto entry = followed.begin(); entry != followed.end();) {
+        if (inScope(entry->second)) {
+          ++entry;
+          continue;
+        }
+        known.erase(Key{cbe::ItemType::Container, entry->first});
+        entry = followed.erase(entry);
+        pruned = true;
+      }
+    }
+  }
+
+  const ListenerFilter                            filter;
+  const delegate::CloudBackendListenerDelegatePtr listener;
+  std::mutex                                      mutex{};
+  // Items seen in scope, so that their removals can be scoped, unless all
+  // removals pass
+  std::set<Key>                                   known{};
+  // Followed subcontainers and their parents
+  std::map<cbe::ContainerId, cbe::ContainerId>    followed{};
+}; // class FilteredListener
+
+/**
+ * @brief Creates a FilteredListener, to be passed into
+ *        cbe::CloudBackend::addListener().
+ *
+ * @param filter    The scope of the changes passed on to \p listener.
+ * @param listener  The listener of the changes within the scope.
+ */
+inline std::shared_ptr<FilteredListener> filteredListener(
+                      ListenerFilter                            filter,
+                      delegate::CloudBackendListenerDelegatePtr listener) {
+  return std::make_shared<FilteredListener>(std::move(filter),
+                                            std::move(listener));
+}
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__FilteredListener_h__
@@ -0,0 +1,322 @@
+#ifndef CBE__util__FlatKeyValues_h__
+#define CBE__util__FlatKeyValues_h__
+
+#include "cbe/Types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ * A flat, contiguous alternative to cbe::KeyValues.
+ *
+ * Requires C++17.
+ */
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief The key/value pairs (metadata) of an object, see cbe::KeyValues,
+ *        in two contiguous blocks: the entries, sorted by key, and the
+ *        characters of the keys and values.
+ *
+ * Building, copying and looking up entries thus takes no allocation per
+ * key, and lookups by std::string_view or C string make no temporary
+ * std::string. FlatKeyValues converts to and from cbe::KeyValues, so that it
+ * can be passed wherever the SDK takes a cbe::KeyValues, and be built from
+ * what it returns, e.g., cbe::Object::keyValues().
+ *
+ * Views returned are valid until the next modification.
+ */
+class FlatKeyValues {
+private:
+  struct Span {
+    std::uint32_t offset;
+    std::uint32_t length;
+  }; // struct Span
+
+  struct Slot {
+    Span  key;
+    Span  value;
+    bool  indexed;
+  }; // struct Slot
+
+  using SlotIterator = std::vector<Slot>::const_iterator;
+
+public:
+  /**
+   * @brief One key/value pair, viewing the storage of the FlatKeyValues.
+   */
+  struct Entry {
+    std::string_view  key{};
+    std::string_view  value{};
+    /** Whether the entry is indexed. */
+    bool              indexed{};
+  }; // struct Entry
+
+  using size_type = std::size_t;
+
+  /**
+   * @brief Iterates the entries, as Entry, in the order of the keys.
+   */
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Entry;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = void;
+    using reference         = Entry;
+
+    Entry operator*() const { return owner->entry(*slot); }
+    const_iterator& operator++() {
+      ++slot;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto result = *this;
+      ++slot;
+      return result;
+    }
+    bool operator==(const const_iterator& other) const {
+      return slot == other.slot;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return slot != other.slot;
+    }
+
+  private:
+    friend class FlatKeyValues;
+
+    const_iterator(const FlatKeyValues& owner, SlotIterator slot)
+      : owner{&owner}, slot{slot} {}
+
+    const FlatKeyValues*  owner;
+    SlotIterator          slot;
+  }; // class const_iterator
+
+  FlatKeyValues() = default;
+
+  FlatKeyValues(std::initializer_list<Entry> entries) {
+    reserve(entries.size(), 0);
+    for (const auto& entry : entries) {
+      set(entry.key, entry.value, entry.indexed);
+    }
+  }
+
+  /**
+   * Copies \p keyValues; the map being sorted, in linear time.
+   */
+  FlatKeyValues(const cbe::KeyValues& keyValues) {
+    std::size_t bytes{};
+    for (const auto& keyValue : keyValues) {
+      bytes += keyValue.first.size() + keyValue.second.first.size();
+    }
+    reserve(keyValues.size(), bytes);
+    for (const auto& keyValue : keyValues) {
+      slots.push_back(store(keyValue.first, keyValue.second.first,
+                            keyValue.second.second));
+    }
+  }
+
+  /**
+   * @return A cbe::KeyValues holding a copy of the entries.
+   */
+  cbe::KeyValues toKeyValues() const {
+    cbe::KeyValues result{};
+    for (const auto& slot : slots) {
+      result.emplace_hint(result.end(),
+                          std::string{text(slot.key)},
+                          std::make_pair(std::string{text(slot.value)},
+                                         slot.indexed));
+    }
+    return result;
+  }
+  /** Same as toKeyValues(). */
+  operator cbe::KeyValues() const { return toKeyValues(); }
+
+  /**
+   * Reserves room for \p count entries, and \p bytes characters of keys and
+   * values.
+   */
+  void reserve(size_type count, std::size_t bytes) {
+    slots.reserve(count);
+    chars.reserve(bytes);
+  }
+
+  size_type size() const { return slots.size(); }
+  bool      empty() const { return slots.empty(); }
+
+  const_iterator begin() const { return const_iterator{*this, slots.begin()}; }
+  const_iterator end() const { return const_iterator{*this, slots.end()}; }
+
+  /**
+   * @return The entry of \p key, or end().
+   */
+  const_iterator find(std::string_view key) const {
+    auto found = lowerBound(key);
+    return found != slots.end() && text(found->key) == key
+             ? const_iterator{*this, found}
+             : end();
+  }
+
+  bool contains(std::string_view key) const { return find(key) != end(); }
+
+  /**
+   * @return The value of \p key, or \p fallback if there is none.
+   */
+  std::string_view value(std::string_view key,
+                         std::string_view fallback) const {
+    auto found = find(key);
+    return found != end() ? (*found).value : fallback;
+  }
+  /** Same as value(std::string_view,std::string_view), with an empty fallback. */
+  std::string_view value(std::string_view key) const {
+    return value(key, std::string_view{});
+  }
+
+  /**
+   * Sets the value of \p key, adding the entry if there is none.
+   *
+   * @return \c true if the entry has been added.
+   */
+  bool set(std::string_view key, std::string_view value, bool indexed) {
+    if (aliases(key) || aliases(value)) {
+      // E.g., a value of another entry, which appending may reallocate, or
+      // copying in place overlap
+      const std::string keyCopy{key};
+      const std::string valueCopy{value};
+      return set(keyCopy, valueCopy, indexed);
+    }
+    auto found = lowerBound(key);
+    if (found != slots.end() && text(found->key) == key) {
+      auto& slot = slots[static_cast<size_type>(found - slots.begin())];
+      if (value.size() <= slot.value.length) {
+        // In place, the characters left over are garbage
+        std::copy(value.begin(), value.end(), chars.begin() + slot.value.offset);
+        garbage += slot.value.length - value.size();
+        slot.value.length = static_cast<std::uint32_t>(value.size());
+      } else {
+        garbage += slot.value.length;
+        slot.value = append(value);
+      }
+      slot.indexed = indexed;
+      collect();
+      return false;
+    }
+    const auto at = found - slots.begin();
+    auto slot = store(key, value, indexed);
+    slots.insert(slots.begin() + at, slot);
+    return true;
+  }
+
+  /**
+   * Removes the entry of \p key.
+   *
+   * @return The number of entries removed, 0 or 1.
+   */
+  size_type erase(std::string_view key) {
+    auto found = lowerBound(key);
+    if (found == slots.end() || text(found->key) != key) {
+      return 0;
+    }
+    garbage += found->key.length + found->value.length;
+    slots.erase(found);
+    collect();
+    return 1;
+  }
+
+  void clear() {
+    slots.clear();
+    chars.clear();
+    garbage = 0;
+  }
+
+  /**
+   * @return The memory held, in bytes.
+   */
+  std::size_t memory() const {
+    return slots.capacity() * sizeof(Slot) + chars.capacity();
+  }
+
+  friend bool operator==(const FlatKeyValues& lh, const FlatKeyValues& rh) {
+    return lh.size() == rh.size() &&
+           std::equal(lh.begin(), lh.end(), rh.begin(),
+                      [](const Entry& l, const Entry& r) {
+                        return l.key == r.key && l.value == r.value &&
+                               l.indexed == r.indexed;
+                      });
+  }
+  friend bool operator!=(const FlatKeyValues& lh, const FlatKeyValues& rh) {
+    return !(lh == rh);
+  }
+
+private:
+  std::string_view text(Span span) const {
+    return std::string_view{chars.data() + span.offset, span.length};
+  }
+
+  bool aliases(std::string_view string) const {
+    const std::less_equal<const char*> lessEqual{};
+    return !string.empty() && lessEqual(chars.data(), string.data()) &&
+           lessEqual(string.data(), chars.data() + chars.size());
+  }
+
+  Entry entry(const Slot& slot) const {
+    return Entry{text(slot.key), text(slot.value), slot.indexed};
+  }
+
+  SlotIterator lowerBound(std::string_view key) const {
+    return std::lower_bound(slots.begin(), slots.end(), key,
+                            [this](const Slot& slot, std::string_view key) {
+                              return text(slot.key) < key;
+                            });
+  }
+
+  Span append(std::string_view string) {
+    const Span span{static_cast<std::uint32_t>(chars.size()),
+                    static_cast<std::uint32_t>(string.size())};
+    chars.append(string.data(), string.size());
+    return span;
+  }
+
+  Slot store(std::string_view key, std::string_view value, bool indexed) {
+    const auto keySpan = append(key);
+    return Slot{keySpan, append(value), indexed};
+  }
+
+  // Compacts the characters once more than half of them are garbage
+  void collect() {
+    if (garbage * 2 <= chars.size()) {
+      return;
+    }
+    std::string compacted{};
+    compacted.reserve(chars.size() - garbage);
+    for (auto& slot : slots) {
+      for (auto* span : {&slot.key, &slot.value}) {
+        const auto offset = static_cast<std::uint32_t>(compacted.size());
+        compacted.append(chars, span->offset, span->length);
+        span->offset = offset;
+      }
+    }
+    chars.swap(compacted);
+    garbage = 0;
+  }
+
+  std::vector<Slot> slots{};
+  std::string       chars{};
+  std::size_t       garbage{};
+}; // class FlatKeyValues
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__FlatKeyValues_h__
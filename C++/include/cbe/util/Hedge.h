@@ -0,0 +1,440 @@
+#ifndef CBE__util__Hedge_h__
+#define CBE__util__Hedge_h__
+
+#include "cbe/delegate/Error.h"
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Cancellation.h"
+#include "cbe/util/Context.h"
+#include "cbe/util/ErrorInfo.h"
+#include "cbe/util/Executor.h"
+#include "cbe/util/Optional.h"
+#include "cbe/util/impl/SyncSignal.h"
+#include "cbe/util/impl/Timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Configuration of a Hedger.
+ */
+struct HedgePolicy {
+  /**
+   * A duplicate request is sent once the call has been outstanding for this
+   * percentile of the recent response times, e.g., 0.95 hedges the slowest
+   * 5% of the calls. The response times are those of the original requests,
+   * whether they win or not.
+   */
+  double                    percentile = 0.95;
+  /**
+   * Bounds of the hedging delay. \c initialDelay is used until
+   * \c minSamples response times have been observed.
+   */
+  std::chrono::milliseconds minDelay{5};
+  std::chrono::milliseconds maxDelay{2000};
+  std::chrono::milliseconds initialDelay{100};
+  std::size_t               minSamples = 20;
+  /**
+   * Number of recent response times the percentile is computed from.
+   */
+  std::size_t               window = 512;
+  /**
+   * Hedging budget: each call deposits \c budgetRatio hedges into a balance
+   * shared by all calls of the Hedger, capped at \c maxBudget, and each hedge
+   * withdraws one. The extra load is thereby limited to this fraction of the
+   * calls, also when the service slows down as a whole.
+   */
+  double                    budgetRatio = 0.1;
+  double                    maxBudget = 10.0;
+  /**
+   * Executor the duplicate requests are sent on, so that the calls are not
+   * made on the timer thread. If null, an executor shared by the SDK headers.
+   */
+  ExecutorPtr               executor{};
+}; // struct HedgePolicy
+
+/**
+ * @brief Counters of a Hedger, see Hedger::stats().
+ */
+struct HedgeStats {
+  std::uint64_t calls{};
+  std::uint64_t hedges{};
+  /** Calls won by the duplicate request. */
+  std::uint64_t hedgeWins{};
+  /** Hedges not sent because the hedging budget was exhausted. */
+  std::uint64_t budgetExhausted{};
+  /** The current hedging delay. */
+  std::chrono::milliseconds delay{};
+}; // struct HedgeStats
+
+    namespace impl {
+
+class HedgeState {
+public:
+  using Clock = Timer::Clock;
+
+  explicit HedgeState(HedgePolicy policy)
+    : policy{std::move(policy)}, delay{this->policy.initialDelay} {
+    latencies.reserve(this->policy.window);
+  }
+
+  const HedgePolicy policy;
+
+  std::chrono::milliseconds onCall() {
+    std::lock_guard<std::mutex> lock{mutex};
+    ++stats_.calls;
+    budget = std::min(policy.maxBudget, budget + policy.budgetRatio);
+    return delay;
+  }
+
+  bool withdrawHedge() {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (budget < 1.0) {
+      ++stats_.budgetExhausted;
+      return false;
+    }
+    budget -= 1.0;
+    ++stats_.hedges;
+    return true;
+  }
+
+  void onHedgeWin() {
+    std::lock_guard<std::mutex> lock{mutex};
+    ++stats_.hedgeWins;
+  }
+
+  // Takes the response times of the original requests only, also of those
+  // the hedge won, so that hedging does not lower the percentile it is
+  // based on
+  void onResponse(Clock::duration latency) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (latencies.size() < policy.window) {
+      latencies.push_back(latency);
+    } else {
+      latencies[next] = latency;
+    }
+    next = (next + 1) % std::max<std::size_t>(policy.window, 1);
+    // The percentile is recomputed every few samples only, keeping the cost
+    // per response low
+    if (latencies.size() >= policy.minSamples && ++sinceUpdate >= 16) {
+      sinceUpdate = 0;
+      auto sorted = latencies;
+      auto nth = sorted.begin() + static_cast<std::ptrdiff_t>(
+                          policy.percentile * double(sorted.size() - 1));
+      std::nth_element(sorted.begin(), nth, sorted.end());
+      delay = std::min(policy.maxDelay,
+                       std::max(policy.minDelay,
+                                std::chrono::duration_cast<
+                                          std::chrono::milliseconds>(*nth)));
+    }
+  }
+
+  HedgeStats stats() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto stats = stats_;
+    stats.delay = delay;
+    return stats;
+  }
+
+private:
+  mutable std::mutex            mutex{};
+  double                        budget{};
+  std::chrono::milliseconds     delay;
+  std::vector<Clock::duration>  latencies{};
+  std::size_t                   next{};
+  std::size_t                   sinceUpdate{};
+  HedgeStats                    stats_{};
+}; // class HedgeState
+
+/**
+ * @brief One call made through Hedger; the first success of the original and
+ *        the duplicate request wins, and an error is reported only once both
+ *        requests have failed.
+ */
+template <class DelegateT, class StartFnT, class CallT>
+class HedgeCall
+    : public std::enable_shared_from_this<HedgeCall<DelegateT, StartFnT, CallT>> {
+public:
+  using Success = typename DelegateT::Success;
+  using Error = typename DelegateT::Error;
+  using Clock = HedgeState::Clock;
+
+  HedgeCall(std::shared_ptr<HedgeState> state,
+            StartFnT                    start,
+            CancellationToken           token,
+            std::shared_ptr<CallT>      call)
+    : state{std::move(state)}, start{std::move(start)},
+      token{std::move(token)}, call{std::move(call)} {}
+
+  void run() {
+    const auto delay = state->onCall();
+    send(false /* hedge */);
+    const auto& policy = state->policy;
+    auto executor = policy.executor ? policy.executor : sharedExecutor();
+    // The timer thread only hands the hedge over to the executor. The call is
+    // kept alive by its pending requests, not by the timer.
+    std::weak_ptr<HedgeCall> weakSelf = this->shared_from_this();
+    const auto id = Timer::instance().schedule(
+      Clock::now() + delay,
+      [weakSelf, executor]() {
+        if (auto self = weakSelf.lock()) {
+          executor->post([self]() { self->sendHedge(); });
+        }
+      });
+    bool completed{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      timer = id;
+      completed = done;
+    }
+    if (completed) { // Before the timer was scheduled
+      Timer::instance().unschedule(id);
+    }
+  }
+
+private:
+  void sendHedge() {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (done || !pending) {
+        return;
+      }
+    }
+    if (!token.isCancelled() && state->withdrawHedge()) {
+      send(true /* hedge */);
+    }
+  }
+
+  // Once done, no longer needed
+  void unscheduleHedge() {
+    Timer::Id id{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      id = timer;
+    }
+    if (id) {
+      Timer::instance().unschedule(id);
+    }
+  }
+
+  void send(bool hedge) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      ++pending;
+      hedged = hedged || hedge;
+    }
+    auto self = this->shared_from_this();
+    const auto sent = Clock::now();
+    start(delegate::impl::makeFnDelegate<DelegateT>(
+      [self, hedge, sent](Success&& success) {
+        if (!hedge) {
+          self->state->onResponse(Clock::now() - sent);
+        }
+        {
+          std::lock_guard<std::mutex> lock{self->mutex};
+          --self->pending;
+          if (self->done) {
+            return; // The other request won
+          }
+          self->done = true;
+        }
+        self->unscheduleHedge();
+        if (hedge) {
+          self->state->onHedgeWin();
+        }
+        self->call->succeed(std::move(success));
+      },
+      [self](Error&& error, cbe::util::Context&& context) {
+        bool hedged{};
+        {
+          std::lock_guard<std::mutex> lock{self->mutex};
+          --self->pending;
+          if (self->done || self->pending) {
+            return; // Already completed, or the other request may succeed
+          }
+          self->done = true;
+          hedged = self->hedged;
+        }
+        self->unscheduleHedge();
+        auto inner = std::move(context);
+        auto fnName = inner.fnName;
+        self->call->fail(std::move(error),
+                         cbe::util::Context{[hedged, inner](std::ostream& os) {
+                                              os << "hedged=" << std::boolalpha
+                                                 << hedged << '\n' << inner;
+                                            },
+                                            fnName.c_str()});
+      }));
+  }
+
+  std::mutex                        mutex{};
+  const std::shared_ptr<HedgeState> state;
+  StartFnT                          start;
+  const CancellationToken           token;
+  const std::shared_ptr<CallT>      call;
+  Timer::Id                         timer{};
+  unsigned                          pending{};
+  bool                              hedged{};
+  bool                              done{};
+}; // class HedgeCall
+
+    } // namespace impl
+
+/**
+ * @brief Sends a duplicate request for slow calls, the first response wins.
+ *
+ * Cuts the tail latency caused by occasional slow responses: once a call has
+ * been outstanding for HedgePolicy::percentile of the recent response times,
+ * the same request is sent once more, and the call completes with whichever
+ * response succeeds first. The duplicates are limited by a budget, hence the
+ * load cannot double when the service slows down as a whole.
+ *
+ * Only to be used for idempotent reads, e.g., cbe::Container::query(),
+ * cbe::CloudBackend::queryWithPath(), cbe::CloudBackend::search(),
+ * cbe::Item::getAcl(), cbe::Object::getStreams(), or the download of small
+ * objects into memory through cbe::delegate::DownloadBinaryDelegate; a
+ * download to a file would have both requests write the same file.
+ *
+ * Create one Hedger per cbe::CloudBackend session, the response times are
+ * tracked per Hedger. The Hedger is a cheap to copy handle of its state.
+ *
+ * \par Example
+ * \code {.cpp}
+ * cbe::util::Hedger hedger{cbe::util::HedgePolicy{}};
+ * hedger.call<cbe::delegate::QueryDelegate>(
+ *   [container](cbe::delegate::QueryDelegatePtr delegate) mutable {
+ *     container.query(delegate);
+ *   },
+ *   [](cbe::QueryResult&& result) { ... },
+ *   [](cbe::delegate::QueryError&& error, cbe::util::Context&& context) { ... });
+ * \endcode
+ */
+class Hedger {
+public:
+  explicit Hedger(HedgePolicy policy)
+    : state{std::make_shared<impl::HedgeState>(std::move(policy))} {}
+
+  /**
+   * @brief Makes an asynchronous call, hedging it should it be slow.
+   *
+   * @tparam DelegateT  Delegate interface of the asynchronous call, any of the
+   *                    interfaces supported by cbe::delegate::impl::FnDelegate.
+   * @param start       Invoked as <code>start(std::shared_ptr<DelegateT>)</code>
+   *                    once per request, and expected to make the asynchronous
+   *                    call with the delegate. The duplicate request is made
+   *                    on HedgePolicy::executor.
+   * @param token       Cancels the call, see CancellationToken.
+   * @param successFn   Invoked as <code>successFn(DelegateT::Success&&)</code>
+   *                    with the first successful response.
+   * @param errorFn     Invoked as
+   *                    <code>errorFn(DelegateT::Error&&, cbe::util::Context&&)</code>
+   *                    once all requests sent have failed.
+   */
+  template <class DelegateT, class StartFnT, class SuccessFnT, class ErrorFnT>
+  void call(StartFnT&&                start,
+            const CancellationToken&  token,
+            SuccessFnT&&              successFn,
+            ErrorFnT&&                errorFn) const {
+    auto cancellable = impl::makeCancellableCall<DelegateT>(
+                                          token,
+                                          std::forward<SuccessFnT>(successFn),
+                                          std::forward<ErrorFnT>(errorFn));
+    using Hedge = impl::HedgeCall<DelegateT,
+                                  typename std::decay<StartFnT>::type,
+                                  typename decltype(cancellable)::element_type>;
+    if (token.isCancelled()) {
+      return; // Completed by the cancellation already
+    }
+    std::make_shared<Hedge>(state, std::forward<StartFnT>(start), token,
+                            std::move(cancellable))
+      ->run();
+  }
+  /**
+   * Same as call(StartFnT&&,const CancellationToken&,SuccessFnT&&,ErrorFnT&&),
+   * but without a token.
+   */
+  template <class DelegateT, class StartFnT, class SuccessFnT, class ErrorFnT>
+  void call(StartFnT&&    start,
+            SuccessFnT&&  successFn,
+            ErrorFnT&&    errorFn) const {
+    call<DelegateT>(std::forward<StartFnT>(start), CancellationToken{},
+                    std::forward<SuccessFnT>(successFn),
+                    std::forward<ErrorFnT>(errorFn));
+  }
+
+#ifndef CBE_NO_SYNC
+  /**
+   * @brief Synchronous [non-throwing] version of
+   *        call(StartFnT&&,const CancellationToken&,SuccessFnT&&,ErrorFnT&&).
+   *
+   * @param[out] error  Return parameter containing the error information in
+   *                    case of a failed call.
+   * @return Empty &mdash; i.e., <code><b>false</b></code> &mdash; indicates a
+   *         failed call, and the error information is passed out via the
+   *         \p error out/return parameter.
+   */
+  template <class DelegateT, class StartFnT>
+  cbe::util::Optional<typename DelegateT::Success> callSync(
+                                  StartFnT&&                      start,
+                                  const CancellationToken&        token,
+                                  typename DelegateT::ErrorInfo&  error) const {
+    using ErrorInfo = typename DelegateT::ErrorInfo;
+    struct Waiter {
+      impl::SyncSignal                                  signal{};
+      cbe::util::Optional<typename DelegateT::Success>  result{};
+      ErrorInfo                                         errorInfo{};
+    };
+    auto waiter = std::make_shared<Waiter>();
+    call<DelegateT>(
+      std::forward<StartFnT>(start), token,
+      [waiter](typename DelegateT::Success&& success) {
+        waiter->result = std::move(success);
+        waiter->signal.notify();
+      },
+      [waiter](typename DelegateT::Error&& error, cbe::util::Context&& context) {
+        waiter->errorInfo = ErrorInfo{std::move(context), std::move(error)};
+        waiter->signal.notify();
+      });
+    waiter->signal.wait();
+    if (!waiter->result) {
+      error = std::move(waiter->errorInfo);
+    }
+    return std::move(waiter->result);
+  }
+  /**
+   * Same as callSync(StartFnT&&,const CancellationToken&,typename DelegateT::ErrorInfo&),
+   * but without a token.
+   */
+  template <class DelegateT, class StartFnT>
+  cbe::util::Optional<typename DelegateT::Success> callSync(
+                                  StartFnT&&                      start,
+                                  typename DelegateT::ErrorInfo&  error) const {
+    return callSync<DelegateT>(std::forward<StartFnT>(start),
+                               CancellationToken{}, error);
+  }
+#endif // #ifndef CBE_NO_SYNC
+
+  /**
+   * @return The counters of the calls made through this Hedger.
+   */
+  HedgeStats stats() const { return state->stats(); }
+
+private:
+  std::shared_ptr<impl::HedgeState> state;
+}; // class Hedger
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Hedge_h__
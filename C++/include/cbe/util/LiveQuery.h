@@ -0,0 +1,379 @@
+#ifndef CBE__util__LiveQuery_h__
+#define CBE__util__LiveQuery_h__
+
+#include "cbe/CloudBackend.h"
+#include "cbe/Filter.h"
+#include "cbe/Item.h"
+#include "cbe/Object.h"
+#include "cbe/QueryChain.h"
+#include "cbe/QueryResult.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/ChangeEvent.h"
+#include "cbe/delegate/LiveQueryDelegate.h"
+#include "cbe/delegate/QueryDelegate.h"
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Context.h"
+#include "cbe/util/impl/ChangeEventListener.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ * Queries whose result is kept up to date, reporting its changes as diffs.
+ *
+ * Requires C++14.
+ */
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+class LiveQueryState final : public ChangeEventListener {
+public:
+  using Diffs = delegate::ItemDiffs;
+
+  LiveQueryState(cbe::ContainerId                containerId,
+                 const cbe::Filter&              filter,
+                 delegate::LiveQueryDelegatePtr  delegate)
+    : containerId{containerId}, order{filter.getItemOrder()},
+      ascending{filter.getAscending()}, dataType{filter.getDataType()},
+      delegate{std::move(delegate)} {}
+
+  LiveQueryState(const LiveQueryState&) = delete;
+  LiveQueryState& operator=(const LiveQueryState&) = delete;
+
+  void loaded(cbe::QueryResult&& queryResult) {
+    auto snapshot = queryResult.getItemsSnapshot();
+    std::deque<ChangeEvent> missed{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (stopped) {
+        return;
+      }
+      rows.reserve(snapshot.size());
+      for (auto& item : snapshot) {
+        auto key = keyOf(item);
+        keys.emplace(item.id(), key);
+        rows.push_back(Row{std::move(key), std::move(item)});
+      }
+      std::sort(rows.begin(), rows.end(),
+                [this](const Row& lh, const Row& rh) {
+                  return less(lh.key, rh.key);
+                });
+      cbe::QueryResult::ItemsSnapshot items{};
+      items.reserve(rows.size());
+      for (const auto& row : rows) {
+        items.push_back(row.item);
+      }
+      isLoaded = true;
+      missed.swap(early);
+      enqueue([items = std::move(items)](
+                    delegate::LiveQueryDelegate& delegate) mutable {
+        delegate.onLiveQueryLoaded(std::move(items));
+      });
+      // The changes received while the query was in flight, applying them
+      // again is harmless
+      Diffs diffs{};
+      for (auto& event : missed) {
+        apply(std::move(event), diffs);
+      }
+      enqueueDiffs(std::move(diffs));
+    }
+    drain();
+  }
+
+  void failed(delegate::QueryError&& error, cbe::util::Context&& context) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (stopped) {
+        return;
+      }
+      stopped = true;
+      enqueue([error = std::move(error), context = std::move(context)](
+                    delegate::LiveQueryDelegate& delegate) mutable {
+        delegate.onLiveQueryError(std::move(error), std::move(context));
+      });
+    }
+    drain();
+  }
+
+  void stop() {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopped = true;
+    early.clear();
+  }
+
+  cbe::QueryResult::ItemsSnapshot items() {
+    std::lock_guard<std::mutex> lock{mutex};
+    cbe::QueryResult::ItemsSnapshot result{};
+    result.reserve(rows.size());
+    for (const auto& row : rows) {
+      result.push_back(row.item);
+    }
+    return result;
+  }
+
+protected:
+  void onChange(ChangeEvent&& event) override {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (stopped) {
+        return;
+      }
+      if (!isLoaded) {
+        early.push_back(std::move(event));
+        return;
+      }
+      Diffs diffs{};
+      apply(std::move(event), diffs);
+      enqueueDiffs(std::move(diffs));
+    }
+    drain();
+  }
+
+private:
+  using Task = std::function<void(delegate::LiveQueryDelegate&)>;
+
+  // The sort key of an item under the order of the filter. Orders that cannot
+  // be evaluated here keep the order of the query result, and append the
+  // items added later.
+  struct Key {
+    std::string   text{};
+    std::uint64_t number{};
+    cbe::ItemId   id{};
+  }; // struct Key
+
+  struct Row {
+    Key       key;
+    cbe::Item item;
+  }; // struct Row
+
+  Key keyOf(const cbe::Item& item) {
+    switch (order) {
+    case cbe::FilterOrder::Title:
+      return Key{item.name(), 0, item.id()};
+    case cbe::FilterOrder::Updated:
+      return Key{std::string{}, item.updated(), item.id()};
+    case cbe::FilterOrder::Length:
+      return Key{std::string{},
+                 item.type() == cbe::ItemType::Object
+                   ? cbe::CloudBackend::castObject(item).length()
+                   : 0,
+                 item.id()};
+    default:
+      return Key{std::string{}, ++arrivals, item.id()};
+    }
+  }
+
+  bool evaluated() const {
+    return order == cbe::FilterOrder::Title ||
+           order == cbe::FilterOrder::Updated ||
+           order == cbe::FilterOrder::Length;
+  }
+
+  bool less(const Key& lh, const Key& rh) const {
+    if (!evaluated()) {
+      return lh.number < rh.number;
+    }
+    const auto& first = ascending ? lh : rh;
+    const auto& second = ascending ? rh : lh;
+    if (first.text != second.text) {
+      return first.text < second.text;
+    }
+    if (first.number != second.number) {
+      return first.number < second.number;
+    }
+    return first.id < second.id;
+  }
+
+  std::size_t position(const Key& key) const {
+    return static_cast<std::size_t>(
+      std::lower_bound(rows.begin(), rows.end(), key,
+                       [this](const Row& row, const Key& key) {
+                         return less(row.key, key);
+                       }) - rows.begin());
+  }
+
+  bool matches(const ChangeEvent& event) const {
+    return (dataType != cbe::ItemType::Object &&
+            dataType != cbe::ItemType::Container) ||
+           event.itemType == dataType;
+  }
+
+  void apply(ChangeEvent&& event, Diffs& diffs) {
+    auto known = keys.find(event.itemId);
+    const bool wasInList = known != keys.end();
+    const bool inList = !event.is(ChangeEvent::Removed) &&
+                        matches(event) &&
+                        event.item.parentId() == containerId;
+    std::size_t from{};
+    if (wasInList) {
+      from = position(known->second);
+      if (!inList) {
+        rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(from));
+        keys.erase(known);
+        diffs.push_back(diff(delegate::ItemDiff::Removed, event, from, 0));
+        return;
+      }
+      if (!evaluated()) {
+        rows[from].item = event.item; // In place
+        diffs.push_back(diff(delegate::ItemDiff::Changed, event, from, from));
+        return;
+      }
+      rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(from));
+    } else if (!inList) {
+      return;
+    }
+    auto key = keyOf(event.item);
+    const auto to = position(key);
+    keys[event.itemId] = key;
+    rows.insert(rows.begin() + static_cast<std::ptrdiff_t>(to),
+                Row{std::move(key), event.item});
+    diffs.push_back(wasInList
+                      ? diff(delegate::ItemDiff::Changed, event, from, to)
+                      : diff(delegate::ItemDiff::Inserted, event, 0, to));
+  }
+
+  static delegate::ItemDiff diff(delegate::ItemDiff::Kind kind,
+                                 ChangeEvent&             event,
+                                 std::size_t              from,
+                                 std::size_t              to) {
+    delegate::ItemDiff result{};
+    result.kind = kind;
+    result.itemId = event.itemId;
+    result.item = event.item;
+    result.from = from;
+    result.to = to;
+    return result;
+  }
+
+  void enqueue(Task&& task) { tasks.push_back(std::move(task)); }
+
+  void enqueueDiffs(Diffs&& diffs) {
+    if (diffs.empty()) {
+      return;
+    }
+    enqueue([diffs = std::move(diffs)](
+                  delegate::LiveQueryDelegate& delegate) mutable {
+      delegate.onLiveQueryDiffs(std::move(diffs));
+    });
+  }
+
+  // Delivers the queued calls in order, one thread at a time, without the
+  // mutex held so that the delegate may call items()
+  void drain() {
+    std::unique_lock<std::mutex> lock{mutex};
+    if (delivering) {
+      return;
+    }
+    delivering = true;
+    while (!tasks.empty()) {
+      auto task = std::move(tasks.front());
+      tasks.pop_front();
+      lock.unlock();
+      task(*delegate);
+      lock.lock();
+    }
+    delivering = false;
+  }
+
+  const cbe::ContainerId                      containerId;
+  const cbe::FilterOrder                      order;
+  const bool                                  ascending;
+  const cbe::ItemType                         dataType;
+  const delegate::LiveQueryDelegatePtr        delegate;
+  std::mutex                                  mutex{};
+  std::vector<Row>                            rows{};
+  std::unordered_map<cbe::ItemId, Key>        keys{};
+  std::uint64_t                               arrivals{};
+  std::deque<ChangeEvent>                     early{};
+  std::deque<Task>                            tasks{};
+  bool                                        isLoaded{};
+  bool                                        stopped{};
+  bool                                        delivering{};
+}; // class LiveQueryState
+
+    } // namespace impl
+
+/**
+ * @brief A query on a container whose result is kept up to date with the
+ *        remote changes, as long as the object lives.
+ *
+ * The items are loaded once, and thereafter each remote change of the
+ * direct items of the container is reported to the delegate as an
+ * delegate::ItemDiff, with the positions of the item in the list; a list
+ * view thus updates in proportion to the change rather than to the list.
+ *
+ * The list is ordered by the cbe::FilterOrder of the filter: by name,
+ * update time or length, ascending or descending. Orders that cannot be
+ * evaluated in the SDK, e.g., relevance, keep the order of the query result
+ * and append the items added later. Of the other criteria of the filter,
+ * only the data type is applied to the changed items; the filter should load
+ * the whole container.
+ */
+class LiveQuery {
+public:
+  /**
+   * Starts the query, see cbe::CloudBackend::query(ContainerId,Filter,QueryDelegatePtr).
+   */
+  LiveQuery(cbe::CloudBackend               cloudBackend,
+            cbe::ContainerId                containerId,
+            cbe::Filter                     filter,
+            delegate::LiveQueryDelegatePtr  delegate)
+    : cloudBackend{std::move(cloudBackend)},
+      state{std::make_shared<impl::LiveQueryState>(containerId, filter,
+                                                   std::move(delegate))},
+      handle{this->cloudBackend.addListener(state)} {
+    // Listening before querying, so that no change is missed
+    std::weak_ptr<impl::LiveQueryState> weakState = state;
+    this->cloudBackend.query(
+      containerId, std::move(filter),
+      delegate::impl::makeFnDelegate<delegate::QueryDelegate>(
+        [weakState](cbe::QueryResult&& queryResult) {
+          if (auto state = weakState.lock()) {
+            state->loaded(std::move(queryResult));
+          }
+        },
+        [weakState](delegate::QueryError&&  error,
+                    cbe::util::Context&&    context) {
+          if (auto state = weakState.lock()) {
+            state->failed(std::move(error), std::move(context));
+          }
+        }));
+  }
+
+  LiveQuery(const LiveQuery&) = delete;
+  LiveQuery& operator=(const LiveQuery&) = delete;
+
+  ~LiveQuery() {
+    state->stop();
+    cloudBackend.removeListener(handle);
+  }
+
+  /**
+   * @return The current items, in the order of the live query.
+   */
+  cbe::QueryResult::ItemsSnapshot items() const { return state->items(); }
+
+private:
+  cbe::CloudBackend                     cloudBackend;
+  std::shared_ptr<impl::LiveQueryState> state;
+  cbe::CloudBackend::ListenerHandle     handle;
+}; // class LiveQuery
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__LiveQuery_h__
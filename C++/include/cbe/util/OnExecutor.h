@@ -0,0 +1,488 @@
+#ifndef CBE__util__OnExecutor_h__
+#define CBE__util__OnExecutor_h__
+
+#include "cbe/Container.h"
+#include "cbe/Object.h"
+#include "cbe/QueryResult.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/CloudBackendListenerDelegate.h"
+#include "cbe/delegate/CreateContainerDelegate.h"
+#include "cbe/delegate/CreateObjectDelegate.h"
+#include "cbe/delegate/DownloadBinaryDelegate.h"
+#include "cbe/delegate/DownloadDelegate.h"
+#include "cbe/delegate/QueryDelegate.h"
+#include "cbe/delegate/UpdateKeyValuesDelegate.h"
+#include "cbe/delegate/UploadDelegate.h"
+#include "cbe/delegate/container/MoveDelegate.h"
+#include "cbe/delegate/container/RemoveDelegate.h"
+#include "cbe/delegate/container/RenameDelegate.h"
+#include "cbe/delegate/object/MoveDelegate.h"
+#include "cbe/delegate/object/RemoveDelegate.h"
+#include "cbe/delegate/object/RenameDelegate.h"
+
+#include "cbe/util/Context.h"
+#include "cbe/util/Executor.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @file
+ * Delivery of the callbacks of delegates and listeners on an executor.
+ *
+ * Requires C++14.
+ */
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+/**
+ * @brief Holds the executor and the user's delegate that an ExecutorDelegate
+ *        posts the callbacks to.
+ */
+template <class DelegateT>
+class ExecutorDelegateBase : public DelegateT {
+public:
+  ExecutorDelegateBase(ExecutorPtr                executor,
+                       std::shared_ptr<DelegateT> delegate)
+    : executor{std::move(executor)}, delegate{std::move(delegate)} {}
+protected:
+  /**
+   * Posts <code>callback(DelegateT&)</code> to the executor. The user's
+   * delegate is kept alive until the callback has run.
+   */
+  template <class CallbackT>
+  void dispatch(CallbackT&& callback) {
+    executor->post([delegate = delegate,
+                    callback = std::forward<CallbackT>(callback)]() mutable {
+      callback(*delegate);
+    });
+  }
+private:
+  ExecutorPtr                 executor;
+  std::shared_ptr<DelegateT>  delegate;
+}; // class ExecutorDelegateBase
+
+/**
+ * @brief Delegate implementation that posts each callback of \p DelegateT to
+ *        an executor, where it is invoked on the user's delegate.
+ *
+ * Specialized below for each supported delegate interface.
+ */
+template <class DelegateT>
+class ExecutorDelegate;
+
+template <>
+class ExecutorDelegate<delegate::QueryDelegate> final
+    : public ExecutorDelegateBase<delegate::QueryDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onQuerySuccess(cbe::QueryResult&& queryResult) override {
+    dispatch([queryResult = std::move(queryResult)](
+                              delegate::QueryDelegate& delegate) mutable {
+      delegate.onQuerySuccess(std::move(queryResult));
+    });
+  }
+  void onQueryError(delegate::QueryError&& error,
+                    cbe::util::Context&&   context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                              delegate::QueryDelegate& delegate) mutable {
+      delegate.onQueryError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<QueryDelegate>
+
+template <>
+class ExecutorDelegate<delegate::CreateContainerDelegate> final
+    : public ExecutorDelegateBase<delegate::CreateContainerDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onCreateContainerSuccess(cbe::Container&& container) override {
+    dispatch([container = std::move(container)](
+                      delegate::CreateContainerDelegate& delegate) mutable {
+      delegate.onCreateContainerSuccess(std::move(container));
+    });
+  }
+  void onCreateContainerError(Error&&              error,
+                              cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::CreateContainerDelegate& delegate) mutable {
+      delegate.onCreateContainerError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<CreateContainerDelegate>
+
+template <>
+class ExecutorDelegate<delegate::CreateObjectDelegate> final
+    : public ExecutorDelegateBase<delegate::CreateObjectDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onCreateObjectSuccess(cbe::Object&& object) override {
+    dispatch([object = std::move(object)](
+                      delegate::CreateObjectDelegate& delegate) mutable {
+      delegate.onCreateObjectSuccess(std::move(object));
+    });
+  }
+  void onCreateObjectError(Error&&              error,
+                           cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::CreateObjectDelegate& delegate) mutable {
+      delegate.onCreateObjectError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<CreateObjectDelegate>
+
+template <>
+class ExecutorDelegate<delegate::UploadDelegate> final
+    : public ExecutorDelegateBase<delegate::UploadDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onUploadSuccess(cbe::Object&& object) override {
+    dispatch([object = std::move(object)](
+                      delegate::UploadDelegate& delegate) mutable {
+      delegate.onUploadSuccess(std::move(object));
+    });
+  }
+  void onUploadError(delegate::TransferError&& transferError,
+                     cbe::util::Context&&      context) override {
+    dispatch([error = std::move(transferError), context = std::move(context)](
+                      delegate::UploadDelegate& delegate) mutable {
+      delegate.onUploadError(std::move(error), std::move(context));
+    });
+  }
+  void onChunkSent(cbe::Object&&  object,
+                   std::uint64_t  sent,
+                   std::uint64_t  total) override {
+    dispatch([object = std::move(object), sent, total](
+                      delegate::UploadDelegate& delegate) mutable {
+      delegate.onChunkSent(std::move(object), sent, total);
+    });
+  }
+}; // class ExecutorDelegate<UploadDelegate>
+
+template <>
+class ExecutorDelegate<delegate::DownloadDelegate> final
+    : public ExecutorDelegateBase<delegate::DownloadDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onDownloadSuccess(cbe::Object&& object, std::string path) override {
+    dispatch([object = std::move(object), path = std::move(path)](
+                      delegate::DownloadDelegate& delegate) mutable {
+      delegate.onDownloadSuccess(std::move(object), std::move(path));
+    });
+  }
+  void onDownloadError(delegate::TransferError&& transferError,
+                       cbe::util::Context&&      context) override {
+    dispatch([error = std::move(transferError), context = std::move(context)](
+                      delegate::DownloadDelegate& delegate) mutable {
+      delegate.onDownloadError(std::move(error), std::move(context));
+    });
+  }
+  void onChunkReceived(cbe::Object&&  object,
+                       std::uint64_t  received,
+                       std::uint64_t  total) override {
+    dispatch([object = std::move(object), received, total](
+                      delegate::DownloadDelegate& delegate) mutable {
+      delegate.onChunkReceived(std::move(object), received, total);
+    });
+  }
+}; // class ExecutorDelegate<DownloadDelegate>
+
+template <>
+class ExecutorDelegate<delegate::DownloadBinaryDelegate> final
+    : public ExecutorDelegateBase<delegate::DownloadBinaryDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onDownloadBinarySuccess(cbe::Object&&           object,
+                               std::unique_ptr<char[]> data) override {
+    // Executor::Task must be copyable, hence the move-only data is boxed
+    auto box = std::make_shared<std::unique_ptr<char[]>>(std::move(data));
+    dispatch([object = std::move(object), box](
+                      delegate::DownloadBinaryDelegate& delegate) mutable {
+      delegate.onDownloadBinarySuccess(std::move(object), std::move(*box));
+    });
+  }
+  void onDownloadBinaryError(delegate::TransferError&& transferError,
+                             cbe::util::Context&&      context) override {
+    dispatch([error = std::move(transferError), context = std::move(context)](
+                      delegate::DownloadBinaryDelegate& delegate) mutable {
+      delegate.onDownloadBinaryError(std::move(error), std::move(context));
+    });
+  }
+  void onChunkReceived(cbe::Object&&  object,
+                       std::uint64_t  received,
+                       std::uint64_t  total) override {
+    dispatch([object = std::move(object), received, total](
+                      delegate::DownloadBinaryDelegate& delegate) mutable {
+      delegate.onChunkReceived(std::move(object), received, total);
+    });
+  }
+}; // class ExecutorDelegate<DownloadBinaryDelegate>
+
+template <>
+class ExecutorDelegate<delegate::UpdateKeyValuesDelegate> final
+    : public ExecutorDelegateBase<delegate::UpdateKeyValuesDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onUpdateKeyValuesSuccess(cbe::Object&& object) override {
+    dispatch([object = std::move(object)](
+                      delegate::UpdateKeyValuesDelegate& delegate) mutable {
+      delegate.onUpdateKeyValuesSuccess(std::move(object));
+    });
+  }
+  void onUpdateKeyValuesError(Error&&              error,
+                              cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::UpdateKeyValuesDelegate& delegate) mutable {
+      delegate.onUpdateKeyValuesError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<UpdateKeyValuesDelegate>
+
+template <>
+class ExecutorDelegate<delegate::container::MoveDelegate> final
+    : public ExecutorDelegateBase<delegate::container::MoveDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onMoveSuccess(cbe::Container&& container) override {
+    dispatch([container = std::move(container)](
+                      delegate::container::MoveDelegate& delegate) mutable {
+      delegate.onMoveSuccess(std::move(container));
+    });
+  }
+  void onMoveError(Error&& error, cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::container::MoveDelegate& delegate) mutable {
+      delegate.onMoveError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<container::MoveDelegate>
+
+template <>
+class ExecutorDelegate<delegate::container::RenameDelegate> final
+    : public ExecutorDelegateBase<delegate::container::RenameDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onRenameSuccess(cbe::Container&& container) override {
+    dispatch([container = std::move(container)](
+                      delegate::container::RenameDelegate& delegate) mutable {
+      delegate.onRenameSuccess(std::move(container));
+    });
+  }
+  void onRenameError(Error&& error, cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::container::RenameDelegate& delegate) mutable {
+      delegate.onRenameError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<container::RenameDelegate>
+
+template <>
+class ExecutorDelegate<delegate::container::RemoveDelegate> final
+    : public ExecutorDelegateBase<delegate::container::RemoveDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onRemoveSuccess(cbe::ItemId containerId, std::string name) override {
+    dispatch([containerId, name = std::move(name)](
+                      delegate::container::RemoveDelegate& delegate) mutable {
+      delegate.onRemoveSuccess(containerId, std::move(name));
+    });
+  }
+  void onRemoveError(Error&& error, cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::container::RemoveDelegate& delegate) mutable {
+      delegate.onRemoveError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<container::RemoveDelegate>
+
+template <>
+class ExecutorDelegate<delegate::object::MoveDelegate> final
+    : public ExecutorDelegateBase<delegate::object::MoveDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onMoveSuccess(cbe::Object&& object) override {
+    dispatch([object = std::move(object)](
+                      delegate::object::MoveDelegate& delegate) mutable {
+      delegate.onMoveSuccess(std::move(object));
+    });
+  }
+  void onMoveError(Error&& error, cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::object::MoveDelegate& delegate) mutable {
+      delegate.onMoveError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<object::MoveDelegate>
+
+template <>
+class ExecutorDelegate<delegate::object::RenameDelegate> final
+    : public ExecutorDelegateBase<delegate::object::RenameDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onRenameSuccess(cbe::Object&& object) override {
+    dispatch([object = std::move(object)](
+                      delegate::object::RenameDelegate& delegate) mutable {
+      delegate.onRenameSuccess(std::move(object));
+    });
+  }
+  void onRenameError(Error&& error, cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::object::RenameDelegate& delegate) mutable {
+      delegate.onRenameError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<object::RenameDelegate>
+
+template <>
+class ExecutorDelegate<delegate::object::RemoveDelegate> final
+    : public ExecutorDelegateBase<delegate::object::RemoveDelegate> {
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onRemoveSuccess(cbe::ItemId objectId, std::string name) override {
+    dispatch([objectId, name = std::move(name)](
+                      delegate::object::RemoveDelegate& delegate) mutable {
+      delegate.onRemoveSuccess(objectId, std::move(name));
+    });
+  }
+  void onRemoveError(Error&& error, cbe::util::Context&& context) override {
+    dispatch([error = std::move(error), context = std::move(context)](
+                      delegate::object::RemoveDelegate& delegate) mutable {
+      delegate.onRemoveError(std::move(error), std::move(context));
+    });
+  }
+}; // class ExecutorDelegate<object::RemoveDelegate>
+
+template <>
+class ExecutorDelegate<delegate::CloudBackendListenerDelegate> final
+    : public ExecutorDelegateBase<delegate::CloudBackendListenerDelegate> {
+  using Listener = delegate::CloudBackendListenerDelegate;
+public:
+  using ExecutorDelegateBase::ExecutorDelegateBase;
+  void onRemoteObjectAdded(cbe::Object&& object) override {
+    dispatch([object = std::move(object)](Listener& listener) mutable {
+      listener.onRemoteObjectAdded(std::move(object));
+    });
+  }
+  void onRemoteObjectMoved(cbe::Object&& object) override {
+    dispatch([object = std::move(object)](Listener& listener) mutable {
+      listener.onRemoteObjectMoved(std::move(object));
+    });
+  }
+  void onRemoteObjectRemoved(cbe::ItemId objectId, std::string name) override {
+    dispatch([objectId, name = std::move(name)](Listener& listener) mutable {
+      listener.onRemoteObjectRemoved(objectId, std::move(name));
+    });
+  }
+  void onRemoteObjectRenamed(cbe::Object&& object) override {
+    dispatch([object = std::move(object)](Listener& listener) mutable {
+      listener.onRemoteObjectRenamed(std::move(object));
+    });
+  }
+  void onRemoteContainerAdded(cbe::Container&& container) override {
+    dispatch([container = std::move(container)](Listener& listener) mutable {
+      listener.onRemoteContainerAdded(std::move(container));
+    });
+  }
+  void onRemoteContainerMoved(cbe::Container&& container) override {
+    dispatch([container = std::move(container)](Listener& listener) mutable {
+      listener.onRemoteContainerMoved(std::move(container));
+    });
+  }
+  void onRemoteContainerRemoved(cbe::ItemId containerId,
+                                std::string name) override {
+    dispatch([containerId, name = std::move(name)](Listener& listener) mutable {
+      listener.onRemoteContainerRemoved(containerId, std::move(name));
+    });
+  }
+  void onRemoteContainerRenamed(cbe::Container&& container) override {
+    dispatch([container = std::move(container)](Listener& listener) mutable {
+      listener.onRemoteContainerRenamed(std::move(container));
+    });
+  }
+}; // class ExecutorDelegate<CloudBackendListenerDelegate>
+
+/**
+ * @brief The first of \p InterfacesT that \p T derives from, \c void if none.
+ */
+template <class T, class... InterfacesT>
+struct InterfaceOf {
+  using type = void;
+};
+
+template <class T, class InterfaceT, class... RestT>
+struct InterfaceOf<T, InterfaceT, RestT...> {
+  using type = typename std::conditional<
+                          std::is_base_of<InterfaceT, T>::value,
+                          InterfaceT,
+                          typename InterfaceOf<T, RestT...>::type>::type;
+};
+
+template <class T>
+using ExecutorInterfaceOf = typename InterfaceOf<T,
+                                    delegate::QueryDelegate,
+                                    delegate::CreateContainerDelegate,
+                                    delegate::CreateObjectDelegate,
+                                    delegate::UploadDelegate,
+                                    delegate::DownloadDelegate,
+                                    delegate::DownloadBinaryDelegate,
+                                    delegate::UpdateKeyValuesDelegate,
+                                    delegate::container::MoveDelegate,
+                                    delegate::container::RenameDelegate,
+                                    delegate::container::RemoveDelegate,
+                                    delegate::object::MoveDelegate,
+                                    delegate::object::RenameDelegate,
+                                    delegate::object::RemoveDelegate,
+                                    delegate::CloudBackendListenerDelegate
+                                    >::type;
+
+    } // namespace impl
+
+/**
+ * @brief Wraps \p delegate so that its callbacks are invoked on \p executor
+ *        rather than on the SDK thread delivering them.
+ *
+ * The returned delegate is passed into the asynchronous call instead of
+ * \p delegate, e.g.:
+ * \code {.cpp}
+ * auto pool = std::make_shared<cbe::util::ThreadPoolExecutor>(8);
+ * container.query(filter, cbe::util::onExecutor(pool, queryDelegate));
+ * cloudBackend.addListener(cbe::util::onExecutor(
+ *                 std::make_shared<cbe::util::Strand>(pool), listener));
+ * \endcode
+ * The SDK thread only pays for posting the callback, hence a slow delegate
+ * no longer holds up the processing of other responses. Progress callbacks,
+ * e.g., delegate::UploadDelegate::onChunkSent(), are posted as well; use a
+ * Strand if their order relative to the completion callback matters.
+ *
+ * Supported for the delegates of the query, create, upload, download,
+ * updateKeyValues, move, rename and remove calls of containers and objects,
+ * and for delegate::CloudBackendListenerDelegate.
+ *
+ * @tparam DelegateT  Type of the user's delegate, deduced from \p delegate.
+ * @param executor    Executor the callbacks are posted to.
+ * @param delegate    The user's delegate, kept alive until the last callback
+ *                    has run.
+ * @return Pointer to the delegate interface implemented by \p DelegateT.
+ */
+template <class DelegateT>
+std::shared_ptr<impl::ExecutorInterfaceOf<DelegateT>> onExecutor(
+                                      ExecutorPtr                executor,
+                                      std::shared_ptr<DelegateT> delegate) {
+  using InterfaceT = impl::ExecutorInterfaceOf<DelegateT>;
+  static_assert(!std::is_void<InterfaceT>::value,
+                "cbe::util::onExecutor(): unsupported delegate type");
+  return std::make_shared<impl::ExecutorDelegate<InterfaceT>>(
+                                std::move(executor),
+                                std::shared_ptr<InterfaceT>{std::move(delegate)});
+}
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__OnExecutor_h__
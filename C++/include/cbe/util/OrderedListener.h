@@ -0,0 +1,391 @@
+#ifndef CBE__util__OrderedListener_h__
+#define CBE__util__OrderedListener_h__
+
+#include "cbe/Container.h"
+#include "cbe/Item.h"
+#include "cbe/Object.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/CloudBackendListenerDelegate.h"
+
+#include "cbe/util/Executor.h"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ * Parallel delivery of the remote changes, in order per container or item.
+ *
+ * Requires C++14.
+ */
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief What the remote changes dispatched by an OrderedListener are ordered
+ *        by.
+ */
+enum class DispatchOrder {
+  /**
+   * The changes of the items of one container are delivered one at a time,
+   * in the order received. So are the changes of one item, also across moves.
+   */
+  PerContainer,
+  /**
+   * The changes of one item are delivered one at a time, in the order
+   * received.
+   */
+  PerItem
+}; // enum class DispatchOrder
+
+/**
+ * @brief Tuning of an OrderedListener.
+ */
+struct OrderedListenerOptions {
+  DispatchOrder order = DispatchOrder::PerContainer;
+  /**
+   * Number of lanes the containers, or items, are spread over. Each lane
+   * delivers one change at a time, so this bounds the parallelism; unrelated
+   * containers sharing a lane are delivered in sequence.
+   */
+  std::size_t   lanes = 64;
+  /**
+   * Executor the lanes run on. If empty, a pool with one thread per hardware
+   * thread is used.
+   */
+  ExecutorPtr   executor{};
+  /**
+   * Number of items whose container is remembered, in
+   * DispatchOrder::PerContainer, so that their removals are ordered with the
+   * changes of the container; the least recently changed items are forgotten
+   * beyond it, their removals then being ordered per item only. Each takes
+   * some 100 bytes. Zero keeps all the items.
+   */
+  std::size_t   maxTrackedItems = std::size_t{1} << 20;
+}; // struct OrderedListenerOptions
+
+    namespace impl {
+
+/**
+ * @brief Like Strand, with the tasks able to suspend the lane until resumed.
+ */
+class Lane : public std::enable_shared_from_this<Lane> {
+public:
+  /** Returns \c false to suspend the lane until resume(). */
+  using Task = std::function<bool()>;
+
+  explicit Lane(ExecutorPtr executor) : executor{std::move(executor)} {}
+
+  Lane(const Lane&) = delete;
+  Lane& operator=(const Lane&) = delete;
+
+  void post(Task&& task) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      tasks.push_back(std::move(task));
+      if (running) {
+        return;
+      }
+      running = true;
+    }
+    resume();
+  }
+
+  void resume() {
+    auto self = shared_from_this();
+    executor->post([self]() { self->run(); });
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock{mutex};
+    while (!tasks.empty()) {
+      auto task = std::move(tasks.front());
+      tasks.pop_front();
+      lock.unlock();
+      if (!task()) {
+        return; // Still running, resumed by another lane
+      }
+      lock.lock();
+    }
+    running = false;
+  }
+
+  const ExecutorPtr executor;
+  std::mutex        mutex{};
+  std::deque<Task>  tasks{};
+  bool              running{};
+}; // class Lane
+
+/**
+ * @brief Runs a callback once it is at the head of two lanes, holding both
+ *        meanwhile.
+ */
+class LaneJoin {
+public:
+  explicit LaneJoin(std::function<void()> callback)
+    : callback{std::move(callback)} {}
+
+  LaneJoin(const LaneJoin&) = delete;
+  LaneJoin& operator=(const LaneJoin&) = delete;
+
+  static void post(std::function<void()>        callback,
+                   const std::shared_ptr<Lane>& first,
+                   const std::shared_ptr<Lane>& second) {
+    auto join = std::make_shared<LaneJoin>(std::move(callback));
+    first->post([join, first]() { return join->arrive(first); });
+    second->post([join, second]() { return join->arrive(second); });
+  }
+
+private:
+  bool arrive(const std::shared_ptr<Lane>& lane) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (!waiting) {
+        waiting = lane;
+        return false;
+      }
+    }
+    callback();
+    waiting->resume();
+    return true;
+  }
+
+  std::mutex            mutex{};
+  std::function<void()> callback;
+  std::shared_ptr<Lane> waiting{};
+}; // class LaneJoin
+
+    } // namespace impl
+
+/**
+ * @brief Listener delivering the remote changes to another listener in
+ *        parallel, yet in order per container or per item.
+ *
+ * The changes are spread over lanes by their container, or item, see
+ * OrderedListenerOptions, and the lanes run in parallel on the executor.
+ * In DispatchOrder::PerContainer, a move is delivered once it is next in
+ * both the lane of the container it left and that of the container it
+ * entered, so the changes of an item stay in order across moves.
+ *
+ * A removal carries the id of the item only; its container is the one the
+ * item was last seen in, see OrderedListenerOptions::maxTrackedItems. The
+ * removal of an item not seen before is ordered with the changes of the item
+ * only.
+ */
+class OrderedListener final : public delegate::CloudBackendListenerDelegate {
+  using Listener = delegate::CloudBackendListenerDelegate;
+public:
+  OrderedListener(delegate::CloudBackendListenerDelegatePtr listener,
+                  OrderedListenerOptions                    options)
+    : listener{std::move(listener)}, order{options.order},
+      maxTrackedItems{options.maxTrackedItems},
+      lanes{makeLanes(std::move(options))} {}
+  /**
+   * Same as OrderedListener(delegate::CloudBackendListenerDelegatePtr,OrderedListenerOptions),
+   * with the default options.
+   */
+  explicit OrderedListener(delegate::CloudBackendListenerDelegatePtr listener)
+    : OrderedListener{std::move(listener), OrderedListenerOptions{}} {}
+
+  OrderedListener(const OrderedListener&) = delete;
+  OrderedListener& operator=(const OrderedListener&) = delete;
+
+  void onRemoteObjectAdded(cbe::Object&& object) override {
+    const auto at = where(object, false);
+    changed(at, [object = std::move(object)](Listener& listener) mutable {
+      listener.onRemoteObjectAdded(std::move(object));
+    });
+  }
+  void onRemoteObjectMoved(cbe::Object&& object) override {
+    const auto at = where(object, true);
+    changed(at, [object = std::move(object)](Listener& listener) mutable {
+      listener.onRemoteObjectMoved(std::move(object));
+    });
+  }
+  void onRemoteObjectRemoved(cbe::ItemId objectId, std::string name) override {
+    removed(objectId, [objectId, name = std::move(name)](
+                                              Listener& listener) mutable {
+      listener.onRemoteObjectRemoved(objectId, std::move(name));
+    });
+  }
+  void onRemoteObjectRenamed(cbe::Object&& object) override {
+    const auto at = where(object, false);
+    changed(at, [object = std::move(object)](Listener& listener) mutable {
+      listener.onRemoteObjectRenamed(std::move(object));
+    });
+  }
+  void onRemoteContainerAdded(cbe::Container&& container) override {
+    const auto at = where(container, false);
+    changed(at,
+            [container = std::move(container)](Listener& listener) mutable {
+      listener.onRemoteContainerAdded(std::move(container));
+    });
+  }
+  void onRemoteContainerMoved(cbe::Container&& container) override {
+    const auto at = where(container, true);
+    changed(at,
+            [container = std::move(container)](Listener& listener) mutable {
+      listener.onRemoteContainerMoved(std::move(container));
+    });
+  }
+  void onRemoteContainerRemoved(cbe::ItemId containerId,
+                                std::string name) override {
+    removed(containerId, [containerId, name = std::move(name)](
+                                              Listener& listener) mutable {
+      listener.onRemoteContainerRemoved(containerId, std::move(name));
+    });
+  }
+  void onRemoteContainerRenamed(cbe::Container&& container) override {
+    const auto at = where(container, false);
+    changed(at,
+            [container = std::move(container)](Listener& listener) mutable {
+      listener.onRemoteContainerRenamed(std::move(container));
+    });
+  }
+
+private:
+  using Lanes = std::vector<std::shared_ptr<impl::Lane>>;
+
+  static Lanes makeLanes(OrderedListenerOptions options) {
+    auto executor = options.executor;
+    if (!executor) {
+      executor = std::make_shared<ThreadPoolExecutor>(
+                                        std::thread::hardware_concurrency());
+    }
+    Lanes lanes(options.lanes ? options.lanes : 1);
+    for (auto& lane : lanes) {
+      lane = std::make_shared<impl::Lane>(executor);
+    }
+    return lanes;
+  }
+
+  const std::shared_ptr<impl::Lane>& lane(cbe::ItemId key) const {
+    return lanes[std::hash<cbe::ItemId>{}(key) % lanes.size()];
+  }
+
+  template <class CallbackT>
+  void post(CallbackT&& callback, const std::shared_ptr<impl::Lane>& lane) {
+    lane->post([listener = listener,
+                callback = std::forward<CallbackT>(callback)]() mutable {
+      callback(*listener);
+      return true;
+    });
+  }
+
+  // Where a change is delivered, computed before the item is moved from
+  struct Position {
+    cbe::ItemId       itemId;
+    cbe::ContainerId  parentId;
+    cbe::ContainerId  oldParentId;
+  }; // struct Position
+
+  static Position where(const cbe::Item& item, bool moved) {
+    const auto parentId = item.parentId();
+    return Position{item.id(), parentId,
+                    moved ? item.oldParentId() : parentId};
+  }
+
+  // The callbacks are posted to the lanes under the mutex, so that the
+  // changes enter the lanes in the order received
+  template <class CallbackT>
+  void changed(const Position& at, CallbackT&& callback) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (order == DispatchOrder::PerItem) {
+      post(std::forward<CallbackT>(callback), lane(at.itemId));
+      return;
+    }
+    track(at.itemId, at.parentId);
+    const auto& to = lane(at.parentId);
+    const auto& from = lane(at.oldParentId);
+    if (from == to) {
+      post(std::forward<CallbackT>(callback), to);
+      return;
+    }
+    impl::LaneJoin::post(
+      [listener = listener,
+       callback = std::forward<CallbackT>(callback)]() mutable {
+        callback(*listener);
+      }, from, to);
+  }
+
+  template <class CallbackT>
+  void removed(cbe::ItemId itemId, CallbackT&& callback) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto parent = parents.find(itemId);
+    if (parent == parents.end()) {
+      post(std::forward<CallbackT>(callback), lane(itemId));
+      return;
+    }
+    post(std::forward<CallbackT>(callback), lane(parent->second.first));
+    recent.erase(parent->second.second);
+    parents.erase(parent);
+  }
+
+  // Remembers the container of the item as the most recent, forgetting the
+  // least recent item beyond maxTrackedItems
+  void track(cbe::ItemId itemId, cbe::ContainerId parentId) {
+    auto parent = parents.find(itemId);
+    if (parent != parents.end()) {
+      parent->second.first = parentId;
+      recent.splice(recent.end(), recent, parent->second.second);
+      return;
+    }
+    if (maxTrackedItems && parents.size() >= maxTrackedItems) {
+      parents.erase(recent.front());
+      recent.pop_front();
+    }
+    parents.emplace(itemId,
+                    std::make_pair(parentId,
+                                   recent.insert(recent.end(), itemId)));
+  }
+
+  const delegate::CloudBackendListenerDelegatePtr listener;
+  const DispatchOrder                             order;
+  const std::size_t                               maxTrackedItems;
+  const Lanes                                     lanes;
+  std::mutex                                      mutex{};
+  // Container each item was last seen in, and its place in recent,
+  // DispatchOrder::PerContainer only
+  std::map<cbe::ItemId,
+           std::pair<cbe::ContainerId,
+                     std::list<cbe::ItemId>::iterator>> parents{};
+  // The tracked items, least recently changed first
+  std::list<cbe::ItemId>                          recent{};
+}; // class OrderedListener
+
+/**
+ * @brief Creates an OrderedListener, to be passed into
+ *        cbe::CloudBackend::addListener().
+ */
+inline std::shared_ptr<OrderedListener> orderedListener(
+                      delegate::CloudBackendListenerDelegatePtr listener,
+                      OrderedListenerOptions                    options) {
+  return std::make_shared<OrderedListener>(std::move(listener),
+                                           std::move(options));
+}
+
+/**
+ * Same as orderedListener(delegate::CloudBackendListenerDelegatePtr,OrderedListenerOptions),
+ * with the default options.
+ */
+inline std::shared_ptr<OrderedListener> orderedListener(
+                      delegate::CloudBackendListenerDelegatePtr listener) {
+  return orderedListener(std::move(listener), OrderedListenerOptions{});
+}
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__OrderedListener_h__
@@ -0,0 +1,309 @@
+#ifndef CBE__util__OutOfCoreItems_h__
+#define CBE__util__OutOfCoreItems_h__
+
+#include "cbe/QueryResult.h"
+#include "cbe/Types.h"
+
+#include "cbe/util/CompactItems.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define CBE_UTIL_SPILL_TO_FILE 1
+#endif
+
+/**
+ * @file
+ * Item sets larger than memory, spilling to a memory-mapped file.
+ *
+ * Requires C++17, and a POSIX system to spill; elsewhere the items are held
+ * in memory.
+ */
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Memory resource that allocates from another up to a budget, and
+ *        beyond it from a temporary file mapped into memory.
+ *
+ * The pages of the file are written back to it by the kernel under memory
+ * pressure, rather than to swap, and are not anonymous memory. The file is
+ * removed as soon as created, and its space released when the resource is
+ * destroyed. Small allocations are carved out of segments of the file, whose
+ * space is reclaimed once all their allocations have been released; large
+ * ones are mapped on their own.
+ *
+ * Not thread safe, as the containers it is meant for.
+ */
+class SpillResource final : public std::pmr::memory_resource {
+public:
+  SpillResource(std::size_t                 memoryBudget,
+                std::string                 directory,
+                std::size_t                 segmentSize,
+                std::pmr::memory_resource*  upstream)
+    : memoryBudget{memoryBudget}, directory{std::move(directory)},
+      segmentSize{pageAligned(std::max<std::size_t>(segmentSize, 1))},
+      upstream{upstream} {}
+
+  SpillResource(const SpillResource&) = delete;
+  SpillResource& operator=(const SpillResource&) = delete;
+
+  ~SpillResource() override {
+#ifdef CBE_UTIL_SPILL_TO_FILE
+    for (const auto& mapping : mappings) {
+      ::munmap(mapping.first, mapping.second.length);
+    }
+    if (file >= 0) {
+      ::close(file);
+    }
+#endif
+  }
+
+  /** Bytes allocated from the upstream resource. */
+  std::size_t memoryBytes() const { return inMemory; }
+  /** Bytes of the file mapped, including the unused tails of segments. */
+  std::size_t spilledBytes() const { return mapped; }
+
+private:
+  struct Mapping {
+    std::size_t length;
+    std::size_t offset; // In the file
+    bool        segment;
+    std::size_t allocations; // Carved out of a segment and not released
+  }; // struct Mapping
+
+  static std::size_t pageSize() {
+#ifdef CBE_UTIL_SPILL_TO_FILE
+    static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+  }
+
+  static std::size_t pageAligned(std::size_t bytes) {
+    const auto page = pageSize();
+    return (bytes + page - 1) / page * page;
+  }
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+#ifdef CBE_UTIL_SPILL_TO_FILE
+    if (inMemory + bytes > memoryBudget && alignment <= pageSize()) {
+      return spill(bytes, alignment);
+    }
+#endif
+    auto* result = upstream->allocate(bytes, alignment);
+    inMemory += bytes;
+    return result;
+  }
+
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+#ifdef CBE_UTIL_SPILL_TO_FILE
+    auto* at = static_cast<char*>(p);
+    auto found = mappings.upper_bound(at);
+    if (found != mappings.begin()) {
+      --found;
+      if (at < found->first + found->second.length) {
+        if (!found->second.segment) {
+          unmap(found);
+        } else if (!--found->second.allocations) {
+          if (found->first == current) {
+            used = 0; // Carved anew
+          } else {
+            unmap(found);
+          }
+        }
+        return;
+      }
+    }
+#endif
+    upstream->deallocate(p, bytes, alignment);
+    inMemory -= bytes;
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+                                                        noexcept override {
+    return this == &other;
+  }
+
+#ifdef CBE_UTIL_SPILL_TO_FILE
+  void* spill(std::size_t bytes, std::size_t alignment) {
+    if (bytes > segmentSize / 4) {
+      return map(pageAligned(bytes), false);
+    }
+    auto start = (used + alignment - 1) / alignment * alignment;
+    if (!current || start + bytes > segmentSize) {
+      auto* segment = map(segmentSize, true);
+      if (current) {
+        // Left to its allocations, and reclaimed with the last of them
+        auto previous = mappings.find(current);
+        if (!previous->second.allocations) {
+          unmap(previous);
+        }
+      }
+      current = segment;
+      start = 0;
+    }
+    used = start + bytes;
+    ++mappings.find(current)->second.allocations;
+    return current + start;
+  }
+
+  char* map(std::size_t length, bool segment) {
+    if (file < 0) {
+      open();
+    }
+    const auto offset = fileSize;
+    if (::ftruncate(file, static_cast<off_t>(offset + length)) != 0) {
+      fail("ftruncate");
+    }
+    fileSize += length;
+    auto* address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, file, static_cast<off_t>(offset));
+    if (address == MAP_FAILED) {
+      fail("mmap");
+    }
+    auto* result = static_cast<char*>(address);
+    mappings.emplace(result, Mapping{length, offset, segment, 0});
+    mapped += length;
+    return result;
+  }
+
+  void unmap(std::map<char*, Mapping>::iterator found) {
+    ::munmap(found->first, found->second.length);
+#if defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+    // Gives the space back to the file system, the file being sparse
+    ::fallocate(file, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                static_cast<off_t>(found->second.offset),
+                static_cast<off_t>(found->second.length));
+#endif
+    mapped -= found->second.length;
+    mappings.erase(found);
+  }
+
+  void open() {
+    auto path = directory;
+    if (path.empty()) {
+      const char* tmp = std::getenv("TMPDIR");
+      path = tmp && *tmp ? tmp : "/tmp";
+    }
+    path += "/cbe-spill-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    file = ::mkstemp(name.data());
+    if (file < 0) {
+      fail("mkstemp");
+    }
+    ::unlink(name.data()); // Removed once closed
+  }
+
+  [[noreturn]] static void fail(const char* what) {
+    throw std::system_error{errno, std::generic_category(),
+                            std::string{"cbe::util::SpillResource: "} + what};
+  }
+#endif
+
+  const std::size_t                 memoryBudget;
+  const std::string                 directory;
+  const std::size_t                 segmentSize;
+  std::pmr::memory_resource* const  upstream;
+  std::size_t                       inMemory{};
+  std::size_t                       mapped{};
+  int                               file{-1};
+  std::size_t                       fileSize{};
+  std::map<char*, Mapping>          mappings{};
+  char*                             current{};
+  std::size_t                       used{};
+}; // class SpillResource
+
+/**
+ * @brief Tuning of an OutOfCoreItems.
+ */
+struct OutOfCoreItemsOptions {
+  /** Memory the items are held in before spilling to the file, in bytes. */
+  std::size_t         memoryBudget = std::size_t{256} << 20;
+  /** Directory of the file; if empty, TMPDIR, or else /tmp. */
+  std::string         directory{};
+  /** Size of the segments of the file small allocations share, in bytes. */
+  std::size_t         segmentSize = std::size_t{64} << 20;
+  CompactItemsOptions items{};
+}; // struct OutOfCoreItemsOptions
+
+/**
+ * @brief The items of query results, as a CompactItems whose storage spills
+ *        to a memory-mapped file beyond a memory budget.
+ *
+ * The items stay iterable, countable and searchable with the same calls as
+ * a cbe::QueryResult, see size() and containsItem(), whatever their number,
+ * so that listing the largest containers does not exhaust memory.
+ */
+class OutOfCoreItems {
+public:
+  explicit OutOfCoreItems(const OutOfCoreItemsOptions& options)
+    : resource{options.memoryBudget, options.directory, options.segmentSize,
+               options.items.memoryResource
+                 ? options.items.memoryResource
+                 : std::pmr::get_default_resource()},
+      store{withResource(options.items, resource)} {}
+  /** Same as OutOfCoreItems(const OutOfCoreItemsOptions&), with the default options. */
+  OutOfCoreItems() : OutOfCoreItems{OutOfCoreItemsOptions{}} {}
+
+  /**
+   * Copies the items of \p queryResult, e.g., of each page of a large query.
+   */
+  void append(const cbe::QueryResult& queryResult) {
+    store.append(queryResult);
+  }
+  void append(const cbe::Item& item) { store.append(item); }
+
+  /** Same as cbe::QueryResult::itemsLoaded(). */
+  std::uint64_t itemsLoaded() const { return store.size(); }
+  /** Same as cbe::QueryResult::containsItem(). */
+  bool containsItem(cbe::ItemId itemId) const {
+    return store.find(itemId) != store.size();
+  }
+
+  CompactItems::Index size() const { return store.size(); }
+  bool                empty() const { return store.empty(); }
+  ItemView operator[](CompactItems::Index index) const { return store[index]; }
+  CompactItems::const_iterator begin() const { return store.begin(); }
+  CompactItems::const_iterator end() const { return store.end(); }
+
+  /** The items, for the rest of the CompactItems calls. */
+  const CompactItems& items() const { return store; }
+
+  /** Bytes of the items in memory. */
+  std::size_t memoryBytes() const { return resource.memoryBytes(); }
+  /** Bytes of the items spilled to the file. */
+  std::size_t spilledBytes() const { return resource.spilledBytes(); }
+
+private:
+  static CompactItemsOptions withResource(CompactItemsOptions       options,
+                                          std::pmr::memory_resource& resource) {
+    options.memoryResource = &resource;
+    return options;
+  }
+
+  SpillResource resource;
+  CompactItems  store;
+}; // class OutOfCoreItems
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__OutOfCoreItems_h__
@@ -0,0 +1,300 @@
+#ifndef CBE__util__QueuedListener_h__
+#define CBE__util__QueuedListener_h__
+
+#include "cbe/Types.h"
+
+#include "cbe/delegate/ChangeEvent.h"
+#include "cbe/delegate/CloudBackendListenerDelegate.h"
+
+#include "cbe/util/Executor.h"
+#include "cbe/util/impl/ChangeEventListener.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief What a QueuedListener does with a change that finds its queue full.
+ */
+enum class OverflowPolicy {
+  /**
+   * The SDK thread waits for room in the queue, which holds back the
+   * reception of further changes.
+   */
+  Block,
+  /**
+   * The oldest queued change is dropped. The listener is told through
+   * QueuedListenerOptions::onResync before the next change delivered, so that
+   * it can re-synchronize.
+   */
+  DropOldest,
+  /**
+   * The change is merged into a queued change of the same item, which then
+   * holds the latest state. If there is none, the SDK thread waits as for
+   * Block.
+   */
+  Coalesce
+}; // enum class OverflowPolicy
+
+/**
+ * @brief Tuning of a QueuedListener.
+ */
+struct QueuedListenerOptions {
+  /** Maximum number of changes queued. */
+  std::size_t     capacity = 10000;
+  OverflowPolicy  overflow = OverflowPolicy::Block;
+  /**
+   * Called with the number of changes dropped by OverflowPolicy::DropOldest,
+   * on the delivery thread, in place of the first change dropped.
+   */
+  std::function<void(std::uint64_t dropped)> onResync{};
+  /**
+   * Executor the changes are delivered on, one at a time. If empty, a thread
+   * dedicated to the listener is used.
+   */
+  ExecutorPtr     executor{};
+}; // struct QueuedListenerOptions
+
+/**
+ * @brief Metrics of the queue of a QueuedListener.
+ */
+struct QueueStats {
+  /** Number of changes queued. */
+  std::size_t               depth{};
+  /** Highest depth so far. */
+  std::size_t               highWater{};
+  /** Estimate of the memory held by the queued changes, in bytes. */
+  std::size_t               bytes{};
+  /** Time the oldest queued change has been waiting. */
+  std::chrono::milliseconds lag{};
+  std::uint64_t             received{};
+  std::uint64_t             delivered{};
+  /** Changes dropped by OverflowPolicy::DropOldest. */
+  std::uint64_t             dropped{};
+  /** Changes merged into a queued one by OverflowPolicy::Coalesce. */
+  std::uint64_t             coalesced{};
+  /** Changes that had to wait for room, OverflowPolicy::Block or Coalesce. */
+  std::uint64_t             blocked{};
+}; // struct QueueStats
+
+    namespace impl {
+
+class ListenerQueue : public std::enable_shared_from_this<ListenerQueue> {
+public:
+  using ChangeEvent = delegate::ChangeEvent;
+  using Clock       = std::chrono::steady_clock;
+
+  ListenerQueue(delegate::CloudBackendListenerDelegatePtr listener,
+                QueuedListenerOptions                     options)
+    : listener{std::move(listener)}, options{std::move(options)},
+      executor{this->options.executor
+                 ? this->options.executor
+                 : std::make_shared<ThreadPoolExecutor>(1)} {
+    if (!this->options.capacity) {
+      this->options.capacity = 1;
+    }
+  }
+
+  ListenerQueue(const ListenerQueue&) = delete;
+  ListenerQueue& operator=(const ListenerQueue&) = delete;
+
+  void push(ChangeEvent&& event) {
+    std::unique_lock<std::mutex> lock{mutex};
+    ++stats.received;
+    if (entries.size() >= options.capacity && !makeRoom(event, lock)) {
+      return; // Coalesced
+    }
+    if (options.overflow == OverflowPolicy::Coalesce) {
+      index[Key{event.itemType, event.itemId}] = popped + entries.size();
+    }
+    stats.bytes += size(event);
+    entries.push_back(Entry{std::move(event), Clock::now()});
+    if (entries.size() > stats.highWater) {
+      stats.highWater = entries.size();
+    }
+    if (draining) {
+      return;
+    }
+    draining = true;
+    lock.unlock();
+    auto self = shared_from_this();
+    executor->post([self]() { self->drain(); });
+  }
+
+  QueueStats snapshot() {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto result = stats;
+    result.depth = entries.size();
+    if (!entries.empty()) {
+      result.lag = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    Clock::now() - entries.front().received);
+    }
+    return result;
+  }
+
+private:
+  using Key = std::pair<cbe::ItemType, cbe::ItemId>;
+
+  struct Entry {
+    ChangeEvent       event;
+    Clock::time_point received;
+  }; // struct Entry
+
+  static std::size_t size(const ChangeEvent& event) {
+    return sizeof(Entry) + event.name.capacity();
+  }
+
+  // Returns false if event was merged into a queued one
+  bool makeRoom(ChangeEvent& event, std::unique_lock<std::mutex>& lock) {
+    switch (options.overflow) {
+    case OverflowPolicy::DropOldest:
+      ++stats.dropped;
+      ++unreported;
+      pop();
+      return true;
+    case OverflowPolicy::Coalesce: {
+      auto found = index.find(Key{event.itemType, event.itemId});
+      if (found != index.end()) {
+        auto& pending = entries[found->second - popped].event;
+        stats.bytes -= size(pending);
+        impl::coalesce(pending, std::move(event));
+        stats.bytes += size(pending);
+        ++stats.coalesced;
+        return false;
+      }
+      break;
+    }
+    case OverflowPolicy::Block:
+      break;
+    }
+    ++stats.blocked;
+    notFull.wait(lock, [this] { return entries.size() < options.capacity; });
+    return true;
+  }
+
+  ChangeEvent pop() {
+    auto event = std::move(entries.front().event);
+    entries.pop_front();
+    auto found = index.find(Key{event.itemType, event.itemId});
+    if (found != index.end() && found->second == popped) {
+      index.erase(found);
+    }
+    ++popped;
+    stats.bytes -= size(event);
+    return event;
+  }
+
+  void drain() {
+    std::unique_lock<std::mutex> lock{mutex};
+    while (!entries.empty() || unreported) {
+      const auto dropped = unreported;
+      unreported = 0;
+      if (dropped) {
+        lock.unlock();
+        if (options.onResync) {
+          options.onResync(dropped);
+        }
+        lock.lock();
+        continue;
+      }
+      auto event = pop();
+      notFull.notify_one();
+      lock.unlock();
+      if (event.kinds) { // Not added and removed while queued
+        impl::deliver(std::move(event), *listener);
+      }
+      lock.lock();
+      ++stats.delivered;
+    }
+    draining = false;
+  }
+
+  const delegate::CloudBackendListenerDelegatePtr listener;
+  QueuedListenerOptions                           options;
+  const ExecutorPtr                               executor;
+  std::mutex                                      mutex{};
+  std::condition_variable                         notFull{};
+  std::deque<Entry>                               entries{};
+  // Position of the queued change of each item, OverflowPolicy::Coalesce only
+  std::map<Key, std::uint64_t>                    index{};
+  std::uint64_t                                   popped{};
+  std::uint64_t                                   unreported{};
+  bool                                            draining{};
+  QueueStats                                      stats{};
+}; // class ListenerQueue
+
+    } // namespace impl
+
+/**
+ * @brief Listener queuing the remote changes, within a bound, for another
+ *        listener that consumes them on a thread of its own.
+ *
+ * The SDK thread is thereby decoupled from a slow listener, without the
+ * changes piling up beyond QueuedListenerOptions::capacity; see
+ * OverflowPolicy for what happens at the bound, and stats() for the depth
+ * and lag of the queue.
+ */
+class QueuedListener final : public impl::ChangeEventListener {
+public:
+  QueuedListener(delegate::CloudBackendListenerDelegatePtr listener,
+                 QueuedListenerOptions                     options)
+    : queue{std::make_shared<impl::ListenerQueue>(std::move(listener),
+                                                  std::move(options))} {}
+  /**
+   * Same as QueuedListener(delegate::CloudBackendListenerDelegatePtr,QueuedListenerOptions),
+   * with the default options.
+   */
+  explicit QueuedListener(delegate::CloudBackendListenerDelegatePtr listener)
+    : QueuedListener{std::move(listener), QueuedListenerOptions{}} {}
+
+  QueuedListener(const QueuedListener&) = delete;
+  QueuedListener& operator=(const QueuedListener&) = delete;
+
+  /**
+   * @return The current metrics of the queue.
+   */
+  QueueStats stats() const { return queue->snapshot(); }
+
+protected:
+  void onChange(ChangeEvent&& event) override {
+    queue->push(std::move(event));
+  }
+
+private:
+  std::shared_ptr<impl::ListenerQueue> queue;
+}; // class QueuedListener
+
+/**
+ * @brief Creates a QueuedListener, to be passed into
+ *        cbe::CloudBackend::addListener().
+ */
+inline std::shared_ptr<QueuedListener> queuedListener(
+                      delegate::CloudBackendListenerDelegatePtr listener,
+                      QueuedListenerOptions                     options) {
+  return std::make_shared<QueuedListener>(std::move(listener),
+                                          std::move(options));
+}
+
+/**
+ * Same as queuedListener(delegate::CloudBackendListenerDelegatePtr,QueuedListenerOptions),
+ * with the default options.
+ */
+inline std::shared_ptr<QueuedListener> queuedListener(
+                      delegate::CloudBackendListenerDelegatePtr listener) {
+  return queuedListener(std::move(listener), QueuedListenerOptions{});
+}
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__QueuedListener_h__
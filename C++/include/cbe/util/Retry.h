@@ -0,0 +1,559 @@
+#ifndef CBE__util__Retry_h__
+#define CBE__util__Retry_h__
+
+#include "cbe/Types.h"
+
+#include "cbe/delegate/Error.h"
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Cancellation.h"
+#include "cbe/util/Context.h"
+#include "cbe/util/ErrorInfo.h"
+#include "cbe/util/Executor.h"
+#include "cbe/util/Optional.h"
+#include "cbe/util/impl/SyncSignal.h"
+#include "cbe/util/impl/Timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Whether a call may be repeated without changing the outcome.
+ */
+enum class Idempotency {
+  /**
+   * Reads, e.g., query, download or getAcl, and calls setting an absolute
+   * state, e.g., rename or updateKeyValues. Retried on any transient error.
+   */
+  Idempotent,
+  /**
+   * Calls creating something, e.g., createObject or upload. Only retried on
+   * errors implying that the service did not process the request, see
+   * RetryPolicy::isRetryableUnprocessed.
+   */
+  NonIdempotent
+}; // enum class Idempotency
+
+    namespace impl {
+
+// Timeouts, throttling, server side errors, and failures without an HTTP
+// status, e.g., a connection failure
+inline bool isTransientError(const delegate::Error& error) {
+  const auto code = error.errorCode;
+  return code < 100 || code == 408 || code == 429 || code == 500 ||
+         code == 502 || code == 503 || code == 504;
+}
+
+inline bool isUnprocessedError(const delegate::Error& error) {
+  return error.errorCode == 429 || error.errorCode == 503;
+}
+
+    } // namespace impl
+
+/**
+ * @brief Configuration of a RetryEngine.
+ */
+struct RetryPolicy {
+  using Predicate = std::function<bool(const delegate::Error&)>;
+
+  /**
+   * Maximum number of attempts per call, including the first one.
+   */
+  unsigned                  maxAttempts = 4;
+  /**
+   * Upper bound of the delay before the first retry. The bound is multiplied
+   * by \c backoffMultiplier for each further retry, up to \c maxBackoff, and
+   * the actual delay is drawn uniformly from zero up to the bound, i.e.,
+   * "full jitter", so that clients failing together do not retry together.
+   */
+  std::chrono::milliseconds initialBackoff{100};
+  std::chrono::milliseconds maxBackoff{5000};
+  double                    backoffMultiplier = 2.0;
+  /**
+   * Retry budget: each call deposits \c budgetRatio retries into a balance
+   * shared by all calls of the engine, and each retry withdraws one, so that
+   * retries add at most this fraction of load on top of the calls. The
+   * balance is refilled with \c minRetriesPerSecond regardless of the call
+   * rate, and capped at \c maxBudget.
+   */
+  double                    budgetRatio = 0.1;
+  double                    minRetriesPerSecond = 10.0;
+  double                    maxBudget = 100.0;
+  /**
+   * Circuit breaker: after \c breakerThreshold consecutive transient errors
+   * the circuit opens, and calls fail fast with error code 503 for
+   * \c breakerOpenDuration. Then a single call is let through as a probe,
+   * closing the circuit on success and opening it again on failure.
+   * Zero disables the breaker.
+   */
+  unsigned                  breakerThreshold = 5;
+  std::chrono::milliseconds breakerOpenDuration{5000};
+  /**
+   * Decides whether an error of an Idempotency::Idempotent call is retried.
+   * Defaults to errors without an HTTP status, and codes 408, 429, 500, 502,
+   * 503 and 504.
+   */
+  Predicate                 isRetryable{impl::isTransientError};
+  /**
+   * Decides whether an error of an Idempotency::NonIdempotent call is
+   * retried, i.e., implies that the request was not processed. Defaults to
+   * codes 429 and 503.
+   */
+  Predicate                 isRetryableUnprocessed{impl::isUnprocessedError};
+  /**
+   * Executor the retries are started on once their backoff has elapsed, so
+   * that the calls are not made on the timer thread. If null, an executor
+   * shared by the SDK headers.
+   */
+  ExecutorPtr               executor{};
+}; // struct RetryPolicy
+
+/**
+ * @brief Counters of a RetryEngine, see RetryEngine::stats().
+ */
+struct RetryStats {
+  std::uint64_t calls{};
+  std::uint64_t attempts{};
+  std::uint64_t retries{};
+  /** Calls succeeding after at least one retry. */
+  std::uint64_t retriedSuccesses{};
+  /** Retries not made because the retry budget was exhausted. */
+  std::uint64_t budgetExhausted{};
+  /** Calls failed fast because the circuit was open. */
+  std::uint64_t circuitRejected{};
+  /** Number of times the circuit has opened. */
+  std::uint64_t circuitOpened{};
+}; // struct RetryStats
+
+    namespace impl {
+
+class RetryState {
+public:
+  using Clock = Timer::Clock;
+
+  explicit RetryState(RetryPolicy policy)
+    : policy{std::move(policy)},
+      budget{std::min(this->policy.maxBudget,
+                      this->policy.minRetriesPerSecond)},
+      refilled{Clock::now()} {}
+
+  const RetryPolicy policy;
+
+  void onCall() {
+    std::lock_guard<std::mutex> lock{mutex};
+    ++stats_.calls;
+    budget = std::min(policy.maxBudget, budget + policy.budgetRatio);
+  }
+
+  // Returns false if the circuit is open, i.e., the attempt must fail fast
+  bool allowAttempt() {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (open) {
+      if (Clock::now() < openUntil || probing) {
+        ++stats_.circuitRejected;
+        return false;
+      }
+      probing = true; // Half open, this attempt is the probe
+    }
+    ++stats_.attempts;
+    return true;
+  }
+
+  void onSuccess(unsigned attempts) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (attempts > 1) {
+      ++stats_.retriedSuccesses;
+    }
+    consecutiveFailures = 0;
+    open = false;
+    probing = false;
+  }
+
+  void onFailure(bool transient) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (!transient) {
+      // The service answered, i.e., it is healthy
+      consecutiveFailures = 0;
+      open = false;
+      probing = false;
+      return;
+    }
+    ++consecutiveFailures;
+    if (policy.breakerThreshold &&
+        (probing || consecutiveFailures >= policy.breakerThreshold)) {
+      if (!open || probing) {
+        ++stats_.circuitOpened;
+      }
+      open = true;
+      probing = false;
+      openUntil = Clock::now() + policy.breakerOpenDuration;
+    }
+  }
+
+  // Withdraws a retry from the budget, false if exhausted
+  bool withdrawRetry() {
+    std::lock_guard<std::mutex> lock{mutex};
+    const auto now = Clock::now();
+    const std::chrono::duration<double> elapsed = now - refilled;
+    refilled = now;
+    budget = std::min(policy.maxBudget,
+                      budget + elapsed.count() * policy.minRetriesPerSecond);
+    if (budget < 1.0) {
+      ++stats_.budgetExhausted;
+      return false;
+    }
+    budget -= 1.0;
+    ++stats_.retries;
+    return true;
+  }
+
+  std::chrono::milliseconds backoff(unsigned retry) const {
+    double bound = double(policy.initialBackoff.count());
+    for (unsigned i = 1; i < retry && bound < policy.maxBackoff.count(); ++i) {
+      bound *= policy.backoffMultiplier;
+    }
+    bound = std::min(bound, double(policy.maxBackoff.count()));
+    thread_local std::mt19937 random{std::random_device{}()};
+    std::uniform_real_distribution<double> jitter{0.0, bound};
+    return std::chrono::milliseconds{
+                              static_cast<std::chrono::milliseconds::rep>(
+                                                              jitter(random))};
+  }
+
+  RetryStats stats() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return stats_;
+  }
+
+  bool circuitOpen() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return open;
+  }
+
+private:
+  mutable std::mutex  mutex{};
+  double              budget;
+  Clock::time_point   refilled;
+  unsigned            consecutiveFailures{};
+  bool                open{};
+  bool                probing{};
+  Clock::time_point   openUntil{};
+  RetryStats          stats_{};
+}; // class RetryState
+
+inline cbe::util::Context attemptsContext(unsigned attempts) {
+  return cbe::util::Context{[attempts](std::ostream& os) {
+                              os << "attempts=" << attempts << '\n';
+                            },
+                            "retry"};
+}
+
+template <class SuccessFnT, class SuccessT, class = void>
+struct TakesContext : std::false_type {};
+template <class SuccessFnT, class SuccessT>
+struct TakesContext<SuccessFnT, SuccessT,
+                    decltype(void(std::declval<SuccessFnT&>()(
+                                    std::declval<SuccessT&&>(),
+                                    std::declval<cbe::util::Context&&>())))>
+    : std::true_type {};
+
+/**
+ * @brief Passes to a successFn taking a cbe::util::Context, as well as the
+ *        success, the number of attempts made.
+ */
+template <class SuccessFnT>
+struct RetrySuccessFn {
+  SuccessFnT                        fn;
+  std::shared_ptr<const unsigned>   attempts;
+
+  template <class SuccessT>
+  void operator()(SuccessT&& success) {
+    fn(std::forward<SuccessT>(success), attemptsContext(*attempts));
+  }
+}; // struct RetrySuccessFn
+
+template <class SuccessFnT>
+typename std::decay<SuccessFnT>::type
+retrySuccessFn(SuccessFnT&& successFn, std::shared_ptr<const unsigned>,
+               std::false_type /*takesContext*/) {
+  return std::forward<SuccessFnT>(successFn);
+}
+
+template <class SuccessFnT>
+RetrySuccessFn<typename std::decay<SuccessFnT>::type>
+retrySuccessFn(SuccessFnT&&                     successFn,
+               std::shared_ptr<const unsigned>  attempts,
+               std::true_type /*takesContext*/) {
+  return RetrySuccessFn<typename std::decay<SuccessFnT>::type>{
+    std::forward<SuccessFnT>(successFn), std::move(attempts)};
+}
+
+/**
+ * @brief One call made through RetryEngine, repeating the attempts until one
+ *        succeeds or the failure is final.
+ */
+template <class DelegateT, class StartFnT, class CallT>
+class RetryCall
+    : public std::enable_shared_from_this<RetryCall<DelegateT, StartFnT, CallT>> {
+public:
+  using Success = typename DelegateT::Success;
+  using Error = typename DelegateT::Error;
+
+  RetryCall(std::shared_ptr<RetryState> state,
+            StartFnT                    start,
+            Idempotency                 idempotency,
+            CancellationToken           token,
+            std::shared_ptr<CallT>      call,
+            std::shared_ptr<unsigned>   attempts)
+    : state{std::move(state)}, start{std::move(start)},
+      idempotency{idempotency}, token{std::move(token)},
+      call{std::move(call)}, attempts{std::move(attempts)} {}
+
+  void attempt() {
+    if (token.isCancelled()) {
+      return; // The call has been completed by the cancellation
+    }
+    if (!state->allowAttempt()) {
+      auto attempts = *this->attempts;
+      call->fail(ErrorAs<Error>::make(
+                   delegate::Error{503, "Service Unavailable",
+                                   "Circuit breaker open"}),
+                 cbe::util::Context{[attempts](std::ostream& os) {
+                                      os << "circuitOpen=true\n"
+                                         << "attempts=" << attempts << '\n';
+                                    },
+                                    "retry"});
+      return;
+    }
+    ++*attempts;
+    auto self = this->shared_from_this();
+    start(delegate::impl::makeFnDelegate<DelegateT>(
+      [self](Success&& success) {
+        self->state->onSuccess(*self->attempts);
+        self->call->succeed(std::move(success));
+      },
+      [self](Error&& error, cbe::util::Context&& context) {
+        self->onError(std::move(error), std::move(context));
+      }));
+  }
+
+private:
+  void onError(Error&& error, cbe::util::Context&& context) {
+    const auto& policy = state->policy;
+    const bool transient = policy.isRetryable && policy.isRetryable(error);
+    state->onFailure(transient);
+    const bool retryable = idempotency == Idempotency::Idempotent
+      ? transient
+      : policy.isRetryableUnprocessed && policy.isRetryableUnprocessed(error);
+    bool budgetExhausted = false;
+    if (retryable && *attempts < policy.maxAttempts && !token.isCancelled()) {
+      if (state->withdrawRetry()) {
+        auto self = this->shared_from_this();
+        auto executor = policy.executor ? policy.executor : sharedExecutor();
+        // The timer thread only hands the retry over to the executor
+        Timer::instance().schedule(Timer::Clock::now() +
+                                                    state->backoff(*attempts),
+                                   [self, executor]() {
+                                     executor->post([self]() {
+                                       self->attempt();
+                                     });
+                                   });
+        return;
+      }
+      budgetExhausted = true;
+    }
+    auto attempts = *this->attempts;
+    auto inner = std::move(context);
+    auto fnName = inner.fnName;
+    call->fail(std::move(error),
+               cbe::util::Context{[attempts, budgetExhausted, inner](
+                                                        std::ostream& os) {
+                                    os << "attempts=" << attempts << '\n';
+                                    if (budgetExhausted) {
+                                      os << "retryBudgetExhausted=true\n";
+                                    }
+                                    os << inner;
+                                  },
+                                  fnName.c_str()});
+  }
+
+  const std::shared_ptr<RetryState> state;
+  StartFnT                          start;
+  const Idempotency                 idempotency;
+  const CancellationToken           token;
+  const std::shared_ptr<CallT>      call;
+  const std::shared_ptr<unsigned>   attempts;
+}; // class RetryCall
+
+    } // namespace impl
+
+/**
+ * @brief Retries failed asynchronous calls according to a RetryPolicy, with
+ *        a retry budget and a circuit breaker shared by all its calls.
+ *
+ * Create one engine per cbe::CloudBackend session and make the calls through
+ * it, rather than writing a retry loop per call. The engine is a cheap to
+ * copy handle of its shared state.
+ *
+ * \par Example
+ * \code {.cpp}
+ * cbe::util::RetryEngine retry{cbe::util::RetryPolicy{}};
+ * retry.call<cbe::delegate::QueryDelegate>(
+ *   [container](cbe::delegate::QueryDelegatePtr delegate) mutable {
+ *     container.query(delegate);
+ *   },
+ *   cbe::util::Idempotency::Idempotent,
+ *   [](cbe::QueryResult&& result) { ... },
+ *   [](cbe::delegate::QueryError&& error, cbe::util::Context&& context) {
+ *     std::cerr << error << context; // context reports attempts=N
+ *   });
+ * \endcode
+ */
+class RetryEngine {
+public:
+  explicit RetryEngine(RetryPolicy policy)
+    : state{std::make_shared<impl::RetryState>(std::move(policy))} {}
+
+  /**
+   * @brief Makes an asynchronous call, retrying it on failure.
+   *
+   * @tparam DelegateT  Delegate interface of the asynchronous call, any of the
+   *                    interfaces supported by cbe::delegate::impl::FnDelegate.
+   * @param start       Invoked as <code>start(std::shared_ptr<DelegateT>)</code>
+   *                    once per attempt, and expected to make the asynchronous
+   *                    call with the delegate. Retries are invoked on
+   *                    RetryPolicy::executor.
+   * @param idempotency Whether the call may be repeated, see Idempotency.
+   * @param token       Cancels the call including its retries, e.g., a token
+   *                    created with withTimeout() to enforce a time budget
+   *                    across all attempts.
+   * @param successFn   Invoked as <code>successFn(DelegateT::Success&&)</code>,
+   *                    or, if it takes one, as
+   *                    <code>successFn(DelegateT::Success&&, cbe::util::Context&&)</code>
+   *                    with a context reporting the number of attempts made.
+   * @param errorFn     Invoked as
+   *                    <code>errorFn(DelegateT::Error&&, cbe::util::Context&&)</code>
+   *                    with the error of the last attempt. The context reports
+   *                    the number of attempts made.
+   */
+  template <class DelegateT, class StartFnT, class SuccessFnT, class ErrorFnT>
+  void call(StartFnT&&                start,
+            Idempotency               idempotency,
+            const CancellationToken&  token,
+            SuccessFnT&&              successFn,
+            ErrorFnT&&                errorFn) const {
+    using Success = typename DelegateT::Success;
+    auto attempts = std::make_shared<unsigned>();
+    auto cancellable = impl::makeCancellableCall<DelegateT>(
+      token,
+      impl::retrySuccessFn(
+        std::forward<SuccessFnT>(successFn), attempts,
+        impl::TakesContext<typename std::decay<SuccessFnT>::type, Success>{}),
+      std::forward<ErrorFnT>(errorFn));
+    using Retry = impl::RetryCall<DelegateT,
+                                  typename std::decay<StartFnT>::type,
+                                  typename decltype(cancellable)::element_type>;
+    state->onCall();
+    std::make_shared<Retry>(state, std::forward<StartFnT>(start), idempotency,
+                            token, std::move(cancellable), std::move(attempts))
+      ->attempt();
+  }
+  /**
+   * Same as call(StartFnT&&,Idempotency,const CancellationToken&,SuccessFnT&&,ErrorFnT&&),
+   * but without a token.
+   */
+  template <class DelegateT, class StartFnT, class SuccessFnT, class ErrorFnT>
+  void call(StartFnT&&    start,
+            Idempotency   idempotency,
+            SuccessFnT&&  successFn,
+            ErrorFnT&&    errorFn) const {
+    call<DelegateT>(std::forward<StartFnT>(start), idempotency,
+                    CancellationToken{}, std::forward<SuccessFnT>(successFn),
+                    std::forward<ErrorFnT>(errorFn));
+  }
+
+#ifndef CBE_NO_SYNC
+  /**
+   * @brief Synchronous [non-throwing] version of
+   *        call(StartFnT&&,Idempotency,const CancellationToken&,SuccessFnT&&,ErrorFnT&&).
+   *
+   * @param[out] error  Return parameter containing the error information of
+   *                    the last attempt in case of a failed call.
+   * @return Empty &mdash; i.e., <code><b>false</b></code> &mdash; indicates a
+   *         failed call, and the error information is passed out via the
+   *         \p error out/return parameter.
+   */
+  template <class DelegateT, class StartFnT>
+  cbe::util::Optional<typename DelegateT::Success> callSync(
+                                  StartFnT&&                      start,
+                                  Idempotency                     idempotency,
+                                  const CancellationToken&        token,
+                                  typename DelegateT::ErrorInfo&  error) const {
+    using ErrorInfo = typename DelegateT::ErrorInfo;
+    struct Waiter {
+      impl::SyncSignal                                  signal{};
+      cbe::util::Optional<typename DelegateT::Success>  result{};
+      ErrorInfo                                         errorInfo{};
+    };
+    auto waiter = std::make_shared<Waiter>();
+    call<DelegateT>(
+      std::forward<StartFnT>(start), idempotency, token,
+      [waiter](typename DelegateT::Success&& success) {
+        waiter->result = std::move(success);
+        waiter->signal.notify();
+      },
+      [waiter](typename DelegateT::Error&& error, cbe::util::Context&& context) {
+        waiter->errorInfo = ErrorInfo{std::move(context), std::move(error)};
+        waiter->signal.notify();
+      });
+    waiter->signal.wait();
+    if (!waiter->result) {
+      error = std::move(waiter->errorInfo);
+    }
+    return std::move(waiter->result);
+  }
+  /**
+   * Same as callSync(StartFnT&&,Idempotency,const CancellationToken&,typename DelegateT::ErrorInfo&),
+   * but without a token.
+   */
+  template <class DelegateT, class StartFnT>
+  cbe::util::Optional<typename DelegateT::Success> callSync(
+                                  StartFnT&&                      start,
+                                  Idempotency                     idempotency,
+                                  typename DelegateT::ErrorInfo&  error) const {
+    return callSync<DelegateT>(std::forward<StartFnT>(start), idempotency,
+                               CancellationToken{}, error);
+  }
+#endif // #ifndef CBE_NO_SYNC
+
+  /**
+   * @return The counters of the calls made through this engine.
+   */
+  RetryStats stats() const { return state->stats(); }
+
+  /**
+   * @return <code><b>true</b></code> while the circuit breaker fails the
+   *         calls fast.
+   */
+  bool circuitOpen() const { return state->circuitOpen(); }
+
+private:
+  std::shared_ptr<impl::RetryState> state;
+}; // class RetryEngine
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Retry_h__
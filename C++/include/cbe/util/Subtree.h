@@ -0,0 +1,593 @@
+#ifndef CBE__util__Subtree_h__
+#define CBE__util__Subtree_h__
+
+#include "cbe/CloudBackend.h"
+#include "cbe/Container.h"
+#include "cbe/Filter.h"
+#include "cbe/Object.h"
+#include "cbe/QueryChain.h"
+#include "cbe/QueryResult.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/DownloadBinarySuccess.h"
+#include "cbe/delegate/Error.h"
+#include "cbe/delegate/container/RemoveDelegate.h"
+#include "cbe/delegate/container/SubtreeDelegate.h"
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Cancellation.h"
+#include "cbe/util/Context.h"
+#include "cbe/util/ErrorInfo.h"
+#include "cbe/util/Optional.h"
+#include "cbe/util/impl/AsyncWindow.h"
+#include "cbe/util/impl/SyncSignal.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace cbe {
+  namespace util {
+
+/**
+ * @brief Tuning of the subtree jobs copySubtree() and removeSubtree().
+ */
+struct SubtreeOptions {
+  /**
+   * Maximum number of service calls the job keeps in flight at the same time.
+   * The calls are pipelined, so the wall clock time of a job is governed by
+   * this number rather than by the round-trip time per item.
+   */
+  std::size_t   maxInFlight = 16;
+  /**
+   * Number of items requested per query when listing a container.
+   */
+  std::uint32_t pageSize = 1000;
+  /**
+   * Name of the new root container created by copySubtree().
+   * Empty implies the same name as the source container.
+   */
+  std::string   name{};
+  /**
+   * Cancels the job: no further service calls are issued once cancelled, and
+   * the job fails with error code cbe::util::cancelledErrorCode as soon as the
+   * calls in flight have returned. The partial copy is left in place.
+   */
+  CancellationToken cancellation{};
+}; // struct SubtreeOptions
+
+    namespace impl {
+
+class SubtreeJob : public std::enable_shared_from_this<SubtreeJob> {
+public:
+  using Delegate  = cbe::delegate::container::SubtreeDelegate;
+  using Error     = Delegate::Error;
+
+  SubtreeJob(delegate::container::SubtreeDelegatePtr  delegate,
+             SubtreeOptions                           options,
+             const char*                              fnName)
+    : delegate{std::move(delegate)}, options{std::move(options)},
+      fnName{fnName} {}
+
+  SubtreeJob(const SubtreeJob&) = delete;
+  SubtreeJob& operator=(const SubtreeJob&) = delete;
+
+  void startCopy(cbe::Container source, cbe::Container destinationParent) {
+    auto self = shared_from_this();
+    success.containerId = source.id();
+    success.name = source.name();
+    start([self, source, destinationParent]() mutable {
+      self->copyContainer(std::move(source), std::move(destinationParent),
+                          true /* isRoot */);
+    });
+  }
+
+  void startRemove(cbe::CloudBackend cloudBackend, cbe::Container container) {
+    auto self = shared_from_this();
+    success.containerId = container.id();
+    success.name = container.name();
+    start([self, cloudBackend, container]() mutable {
+      self->removeContainer(std::move(cloudBackend), std::move(container));
+    });
+  }
+
+private:
+  void start(AsyncWindow::Task rootTask) {
+    auto self = shared_from_this();
+    window = std::make_shared<AsyncWindow>(options.maxInFlight,
+                                           [self]() { self->finish(); });
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      ++success.progress.containersFound;
+    }
+    window->post(std::move(rootTask));
+    std::weak_ptr<SubtreeJob> weakSelf = self;
+    auto registration = options.cancellation.onCancel([weakSelf]() {
+      if (auto self = weakSelf.lock()) {
+        self->cancel();
+      }
+    });
+    std::lock_guard<std::mutex> lock{mutex};
+    if (window) {
+      cancellation = std::move(registration);
+    }
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  void copyContainer(cbe::Container source,
+                     cbe::Container destinationParent,
+                     bool           isRoot) {
+    auto self = shared_from_this();
+    auto name = isRoot && !options.name.empty() ? options.name : source.name();
+    destinationParent.createContainer(
+      name,
+      delegate::impl::makeFnDelegate<delegate::CreateContainerDelegate>(
+        [self, source, isRoot](cbe::Container&& created) {
+          {
+            std::lock_guard<std::mutex> lock{self->mutex};
+            self->created.insert(created.id());
+            ++self->success.progress.containersDone;
+            if (isRoot) {
+              self->success.container = created;
+            }
+          }
+          self->listPage(source, std::move(created), 0 /* offset */);
+          self->progress();
+          self->window->complete();
+        },
+        [self](Error&& error, cbe::util::Context&& context) {
+          self->fail(std::move(error), std::move(context));
+        }));
+  }
+
+  void listPage(cbe::Container source,
+                cbe::Container destination,
+                std::uint32_t  offset) {
+    auto self = shared_from_this();
+    window->post([self, source, destination, offset]() mutable {
+      auto filter = cbe::Filter{}.setOffset(offset)
+                                 .setCount(self->options.pageSize);
+      source.query(
+        std::move(filter),
+        delegate::impl::makeFnDelegate<delegate::QueryDelegate>(
+          [self, source, destination, offset](cbe::QueryResult&& queryResult) {
+            self->onPage(source, destination, offset, queryResult);
+            self->window->complete();
+          },
+          [self](delegate::QueryError&& error, cbe::util::Context&& context) {
+            self->fail(std::move(error), std::move(context));
+          }));
+    });
+  }
+
+  void onPage(const cbe::Container&   source,
+              const cbe::Container&   destination,
+              std::uint32_t           offset,
+              const cbe::QueryResult& queryResult) {
+    auto self = shared_from_this();
+    const auto loaded = queryResult.itemsLoaded();
+    if (loaded && offset + loaded < queryResult.totalCount()) {
+      listPage(source, destination,
+               static_cast<std::uint32_t>(offset + loaded));
+    }
+    for (auto& item : queryResult.getItemsSnapshot()) {
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (created.count(item.id())) {
+          continue; // Copying into the own subtree, skip the copies
+        }
+        if (item.type() == cbe::ItemType::Container) {
+          ++success.progress.containersFound;
+        } else if (item.type() == cbe::ItemType::Object) {
+          ++success.progress.objectsFound;
+        }
+      }
+      if (item.type() == cbe::ItemType::Container) {
+        auto container = cbe::CloudBackend::castContainer(item);
+        window->post([self, container, destination]() {
+          self->copyContainer(container, destination, false /* isRoot */);
+        });
+      } else if (item.type() == cbe::ItemType::Object) {
+        auto object = cbe::CloudBackend::castObject(item);
+        window->post([self, object, destination]() {
+          self->copyObject(object, destination);
+        });
+      }
+    }
+  }
+
+  void copyObject(cbe::Object source, cbe::Container destination) {
+    auto self = shared_from_this();
+    const auto length = source.length();
+    if (!length) {
+      destination.createObject(
+        source.name(), source.keyValues(),
+        delegate::impl::makeFnDelegate<delegate::CreateObjectDelegate>(
+          [self](cbe::Object&&) { self->objectDone(0); },
+          [self](Error&& error, cbe::util::Context&& context) {
+            self->fail(std::move(error), std::move(context));
+          }));
+      return;
+    }
+    // Objects with data are copied by downloading the data into memory and
+    // uploading it as a new object, followed by its key/values if any
+    source.download(
+      std::size_t(length),
+      delegate::impl::makeFnDelegate<delegate::DownloadBinaryDelegate>(
+        [self, source, destination, length](
+                                    delegate::DownloadBinarySuccess&& downloaded
+                                  ) mutable {
+          std::shared_ptr<char> data{downloaded.data.release(),
+                                     std::default_delete<char[]>{}};
+          auto keyValues = source.keyValues();
+          destination.upload(
+            source.name(), length, data.get(),
+            delegate::impl::makeFnDelegate<delegate::UploadDelegate>(
+              [self, data, keyValues, length](cbe::Object&& uploaded) mutable {
+                if (keyValues.empty()) {
+                  self->objectDone(length);
+                  return;
+                }
+                uploaded.updateKeyValues(
+                  std::move(keyValues),
+                  delegate::impl::makeFnDelegate<
+                                            delegate::UpdateKeyValuesDelegate>(
+                    [self, length](cbe::Object&&) { self->objectDone(length); },
+                    [self](Error&& error, cbe::util::Context&& context) {
+                      self->fail(std::move(error), std::move(context));
+                    }));
+              },
+              [self](delegate::TransferError&& error,
+                     cbe::util::Context&&      context) {
+                self->fail(std::move(error), std::move(context));
+              }));
+        },
+        [self](delegate::TransferError&& error, cbe::util::Context&& context) {
+          self->fail(std::move(error), std::move(context));
+        }));
+  }
+
+  void objectDone(std::uint64_t bytes) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      ++success.progress.objectsDone;
+      success.progress.bytesDone += bytes;
+    }
+    progress();
+    window->complete();
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  void removeContainer(cbe::CloudBackend cloudBackend,
+                       cbe::Container    container) {
+    auto self = shared_from_this();
+    const auto parentId = container.parentId();
+    container.remove(
+      delegate::impl::makeFnDelegate<delegate::container::RemoveDelegate>(
+        [self, cloudBackend, parentId](
+                              delegate::container::RemoveSuccess&&) mutable {
+          self->verifyRemoved(std::move(cloudBackend), parentId, 0 /* offset */);
+          self->window->complete();
+        },
+        [self](Error&& error, cbe::util::Context&& context) {
+          self->fail(std::move(error), std::move(context));
+        }));
+  }
+
+  // Verifies, bypassing the cache, that the removed container is no longer
+  // listed in its parent
+  void verifyRemoved(cbe::CloudBackend  cloudBackend,
+                     cbe::ContainerId   parentId,
+                     std::uint32_t      offset) {
+    auto self = shared_from_this();
+    window->post([self, cloudBackend, parentId, offset]() mutable {
+      auto filter = cbe::Filter{}.setDataType(cbe::ItemType::Container)
+                                 .setByPassCache(true)
+                                 .setOffset(offset)
+                                 .setCount(self->options.pageSize);
+      cloudBackend.query(
+        parentId, std::move(filter),
+        delegate::impl::makeFnDelegate<delegate::QueryDelegate>(
+          [self, cloudBackend, parentId, offset](
+                                      cbe::QueryResult&& queryResult) mutable {
+            const auto loaded = queryResult.itemsLoaded();
+            if (queryResult.containsItem(self->success.containerId)) {
+              self->fail(Error{409, "Conflict",
+                               "Container still present after remove"},
+                         cbe::util::Context{});
+              return;
+            }
+            if (loaded && offset + loaded < queryResult.totalCount()) {
+              self->verifyRemoved(std::move(cloudBackend), parentId,
+                                  static_cast<std::uint32_t>(offset + loaded));
+            } else {
+              std::lock_guard<std::mutex> lock{self->mutex};
+              ++self->success.progress.containersDone;
+            }
+            self->window->complete();
+          },
+          [self](delegate::QueryError&& error, cbe::util::Context&& context) {
+            self->fail(std::move(error), std::move(context));
+          }));
+    });
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  void progress() {
+    delegate::container::SubtreeProgress snapshot{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      snapshot = success.progress;
+    }
+    delegate->onSubtreeProgress(snapshot);
+  }
+
+  void fail(Error&& error, cbe::util::Context&& context) {
+    setFailure(std::move(error), std::move(context));
+    window->stop();
+    window->complete();
+  }
+
+  // Unlike fail(), not called from a task in flight, hence the window may
+  // already be gone
+  void cancel() {
+    std::shared_ptr<AsyncWindow> window{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      window = this->window;
+    }
+    if (window) {
+      auto error = options.cancellation.error();
+      auto context = cancelledContext(error);
+      setFailure(std::move(error), std::move(context));
+      window->stop();
+    }
+  }
+
+  void setFailure(Error&& error, cbe::util::Context&& context) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (!failed) {
+      failed = true;
+      failure = std::move(error);
+      failureContext = std::move(context);
+    }
+  }
+
+  // Called by the window once nothing is queued or in flight; cancel() may
+  // still race with it, hence the state is taken under the mutex
+  void finish() {
+    bool                                hasFailed{};
+    Error                               error{};
+    cbe::util::Context                  inner{};
+    delegate::container::SubtreeSuccess result{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      hasFailed = failed;
+      error = std::move(failure);
+      inner = std::move(failureContext);
+      result = std::move(success);
+    }
+    if (hasFailed) {
+      const auto root = result.containerId;
+      delegate->onSubtreeError(
+        std::move(error),
+        cbe::util::Context{[root, inner](std::ostream& os) {
+                             os << "rootContainerId=" << root << '\n' << inner;
+                           },
+                           fnName});
+    } else {
+      delegate->onSubtreeSuccess(std::move(result));
+    }
+    delegate.reset();
+    CancellationRegistration registration{};
+    std::lock_guard<std::mutex> lock{mutex};
+    window.reset();
+    registration = std::move(cancellation);
+  }
+
+  std::mutex                                mutex{};
+  delegate::container::SubtreeDelegatePtr   delegate;
+  const SubtreeOptions                      options;
+  const char* const                         fnName;
+  std::shared_ptr<AsyncWindow>              window{};
+  CancellationRegistration                  cancellation{};
+  std::set<cbe::ItemId>                     created{};
+  delegate::container::SubtreeSuccess       success{};
+  bool                                      failed{};
+  Error                                     failure{};
+  cbe::util::Context                        failureContext{};
+}; // class SubtreeJob
+
+#ifndef CBE_NO_SYNC
+class SubtreeWaiter : public delegate::container::SubtreeDelegate {
+public:
+  using ErrorInfo = delegate::container::SubtreeDelegate::ErrorInfo;
+
+  cbe::util::Optional<delegate::container::SubtreeSuccess> wait(
+                                                            ErrorInfo& error) {
+    signal.wait();
+    if (!result) {
+      error = std::move(errorInfo);
+    }
+    return std::move(result);
+  }
+private:
+  void onSubtreeSuccess(delegate::container::SubtreeSuccess&& success) override {
+    result = std::move(success);
+    signal.notify();
+  }
+  void onSubtreeError(Error&& error, cbe::util::Context&& context) override {
+    errorInfo = ErrorInfo{std::move(context), std::move(error)};
+    signal.notify();
+  }
+
+  SyncSignal                                                signal{};
+  cbe::util::Optional<delegate::container::SubtreeSuccess>  result{};
+  ErrorInfo                                                 errorInfo{};
+}; // class SubtreeWaiter
+#endif // #ifndef CBE_NO_SYNC
+
+    } // namespace impl
+
+/**
+ * @brief Copies a container with all its content.
+ *
+ * Creates a copy of \p source, and recursively of all its containers and
+ * objects, as a new container inside \p destinationParent. Objects with data
+ * are copied including their data and key/values.
+ *
+ * The job pipelines up to SubtreeOptions::maxInFlight service calls at the
+ * same time. Progress is reported through
+ * delegate::container::SubtreeDelegate::onSubtreeProgress(), and completion
+ * through either
+ * delegate::container::SubtreeDelegate::onSubtreeSuccess() or
+ * delegate::container::SubtreeDelegate::onSubtreeError().
+ *
+ * \note A failed copy is not rolled back, the partial copy is left in
+ * \p destinationParent. Copying a container into its own subtree is permitted,
+ * the newly created copies are not copied again.
+ *
+ * @param source            The container to copy.
+ * @param destinationParent The container in which the copy is created.
+ * @param delegate          Pointer to a delegate::container::SubtreeDelegate
+ *                          instance that is implemented by the user.
+ * @param options           Tuning of the job, see SubtreeOptions.
+ */
+inline void copySubtree(cbe::Container                          source,
+                        cbe::Container                          destinationParent,
+                        delegate::container::SubtreeDelegatePtr delegate,
+                        SubtreeOptions                          options) {
+  auto job = std::make_shared<impl::SubtreeJob>(std::move(delegate),
+                                                std::move(options),
+                                                "copySubtree");
+  job->startCopy(std::move(source), std::move(destinationParent));
+}
+/**
+ * Same as copySubtree(cbe::Container,cbe::Container,delegate::container::SubtreeDelegatePtr,SubtreeOptions),
+ * but with default SubtreeOptions.
+ */
+inline void copySubtree(cbe::Container                          source,
+                        cbe::Container                          destinationParent,
+                        delegate::container::SubtreeDelegatePtr delegate) {
+  copySubtree(std::move(source), std::move(destinationParent),
+              std::move(delegate), SubtreeOptions{});
+}
+
+/**
+ * @brief Removes a container with all its content, and verifies the removal.
+ *
+ * Calls cbe::Container::remove(), which removes the whole subtree, and then
+ * lists the parent container bypassing the cache to verify that the container
+ * is gone. Should the container still be listed, the job fails with error
+ * code 409.
+ *
+ * @param cloudBackend  The session used for the verification query.
+ * @param container     The container to remove.
+ * @param delegate      Pointer to a delegate::container::SubtreeDelegate
+ *                      instance that is implemented by the user.
+ * @param options       Tuning of the job, see SubtreeOptions.
+ */
+inline void removeSubtree(cbe::CloudBackend                       cloudBackend,
+                          cbe::Container                          container,
+                          delegate::container::SubtreeDelegatePtr delegate,
+                          SubtreeOptions                          options) {
+  auto job = std::make_shared<impl::SubtreeJob>(std::move(delegate),
+                                                std::move(options),
+                                                "removeSubtree");
+  job->startRemove(std::move(cloudBackend), std::move(container));
+}
+/**
+ * Same as removeSubtree(cbe::CloudBackend,cbe::Container,delegate::container::SubtreeDelegatePtr,SubtreeOptions),
+ * but with default SubtreeOptions.
+ */
+inline void removeSubtree(cbe::CloudBackend                       cloudBackend,
+                          cbe::Container                          container,
+                          delegate::container::SubtreeDelegatePtr delegate) {
+  removeSubtree(std::move(cloudBackend), std::move(container),
+                std::move(delegate), SubtreeOptions{});
+}
+
+#ifndef CBE_NO_SYNC
+/**
+ * Forms the type of the \p error return parameter for the synchronous versions
+ * of copySubtree() and removeSubtree().
+ * <br>See delegate::container::SubtreeDelegate::ErrorInfo
+ */
+using SubtreeError = delegate::container::SubtreeDelegate::ErrorInfo;
+/**
+ * @brief Synchronous [non-throwing] copySubtree
+ *
+ * <b>Synchronous</b> version of
+ * copySubtree(cbe::Container,cbe::Container,delegate::container::SubtreeDelegatePtr,SubtreeOptions)
+ * , and <b>throws <u>no</u> exception</b> on error, instead the out/return
+ * parameter \p error is used to provide the error information in connection
+ * with a failed call.
+ *
+ * @param[out] error
+ *              Return parameter containing the error information in case
+ *              of a failed call.
+ *
+ * @return Empty &mdash; i.e., <code><b>false</b></code> &mdash; indicates a
+ *         failed call, and the error information is passed out via the
+ *         \p error out/return parameter.
+ */
+inline cbe::util::Optional<delegate::container::SubtreeSuccess> copySubtree(
+                                      cbe::Container  source,
+                                      cbe::Container  destinationParent,
+                                      SubtreeOptions  options,
+                                      SubtreeError&   error) {
+  auto waiter = std::make_shared<impl::SubtreeWaiter>();
+  copySubtree(std::move(source), std::move(destinationParent), waiter,
+              std::move(options));
+  return waiter->wait(error);
+}
+/**
+ * Same as copySubtree(cbe::Container,cbe::Container,SubtreeOptions,SubtreeError&),
+ * but with default SubtreeOptions.
+ */
+inline cbe::util::Optional<delegate::container::SubtreeSuccess> copySubtree(
+                                      cbe::Container  source,
+                                      cbe::Container  destinationParent,
+                                      SubtreeError&   error) {
+  return copySubtree(std::move(source), std::move(destinationParent),
+                     SubtreeOptions{}, error);
+}
+/**
+ * @brief Synchronous [non-throwing] removeSubtree
+ *
+ * <b>Synchronous</b> version of
+ * removeSubtree(cbe::CloudBackend,cbe::Container,delegate::container::SubtreeDelegatePtr,SubtreeOptions)
+ * , see copySubtree(cbe::Container,cbe::Container,SubtreeOptions,SubtreeError&)
+ * for the error handling.
+ */
+inline cbe::util::Optional<delegate::container::SubtreeSuccess> removeSubtree(
+                                      cbe::CloudBackend cloudBackend,
+                                      cbe::Container    container,
+                                      SubtreeOptions    options,
+                                      SubtreeError&     error) {
+  auto waiter = std::make_shared<impl::SubtreeWaiter>();
+  removeSubtree(std::move(cloudBackend), std::move(container), waiter,
+                std::move(options));
+  return waiter->wait(error);
+}
+/**
+ * Same as removeSubtree(cbe::CloudBackend,cbe::Container,SubtreeOptions,SubtreeError&),
+ * but with default SubtreeOptions.
+ */
+inline cbe::util::Optional<delegate::container::SubtreeSuccess> removeSubtree(
+                                      cbe::CloudBackend cloudBackend,
+                                      cbe::Container    container,
+                                      SubtreeError&     error) {
+  return removeSubtree(std::move(cloudBackend), std::move(container),
+                       SubtreeOptions{}, error);
+}
+#endif // #ifndef CBE_NO_SYNC
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Subtree_h__
@@ -0,0 +1,133 @@
+#ifndef CBE__util__Sync_h__
+#define CBE__util__Sync_h__
+
+#ifndef CBE_NO_SYNC
+
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Cancellation.h"
+#include "cbe/util/Context.h"
+#include "cbe/util/Deadline.h"
+#include "cbe/util/Optional.h"
+#include "cbe/util/impl/SyncSignal.h"
+
+#include <memory>
+#include <utility>
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+/**
+ * @brief State shared by callSync() and the delegate of the call.
+ */
+template <class DelegateT>
+class SyncCall {
+public:
+  using Success = typename DelegateT::Success;
+  using ErrorInfo = typename DelegateT::ErrorInfo;
+
+  SyncSignal                    signal{};
+  cbe::util::Optional<Success>  result{};
+  ErrorInfo                     errorInfo{};
+}; // class SyncCall
+
+    } // namespace impl
+
+/**
+ * @brief Makes a cancellable synchronous [non-throwing] call out of an
+ *        asynchronous call.
+ *
+ * Same as callSync(StartFnT&&,typename DelegateT::ErrorInfo&), except that
+ * cancelling \p token, e.g., from another thread, makes the call return right
+ * away with error code cbe::util::cancelledErrorCode, or with
+ * cbe::util::deadlineExceededErrorCode for a token created by withTimeout() or
+ * withDeadline(). The call is not started at all should \p token already be
+ * cancelled.
+ */
+template <class DelegateT, class StartFnT>
+cbe::util::Optional<typename DelegateT::Success> callSync(
+                                    StartFnT&&                      start,
+                                    const CancellationToken&        token,
+                                    typename DelegateT::ErrorInfo&  error) {
+  using Call = impl::SyncCall<DelegateT>;
+  auto call = std::make_shared<Call>();
+  auto onSuccess = [call](typename Call::Success&& success) {
+    call->result = std::move(success);
+    call->signal.notify();
+  };
+  auto onError = [call](typename DelegateT::Error&& error,
+                        cbe::util::Context&&        context) {
+    call->errorInfo = typename Call::ErrorInfo{std::move(context),
+                                               std::move(error)};
+    call->signal.notify();
+  };
+  if (!token.canBeCancelled()) {
+    std::forward<StartFnT>(start)(delegate::impl::makeFnDelegate<DelegateT>(
+                                    std::move(onSuccess), std::move(onError)));
+  } else {
+    auto delegate = impl::makeCancellableFnDelegate<DelegateT>(
+                                    token,
+                                    std::move(onSuccess), std::move(onError));
+    if (!token.isCancelled()) {
+      std::forward<StartFnT>(start)(std::move(delegate));
+    }
+  }
+  call->signal.wait();
+  if (!call->result) {
+    error = std::move(call->errorInfo);
+  }
+  return std::move(call->result);
+}
+
+/**
+ * @brief Makes a synchronous [non-throwing] call out of an asynchronous call.
+ *
+ * Works with any of the delegate interfaces supported by
+ * cbe::delegate::impl::FnDelegate, and follows the conventions of the
+ * synchronous non-throwing calls of the SDK. The calling thread waits through
+ * an impl::SyncSignal, i.e., it spins briefly before falling asleep, which
+ * saves the condition variable round trip on responses served from the cache.
+ * See the SyncBenchmark example for a comparison with the synchronous calls of
+ * the SDK.
+ *
+ * Should a default timeout be set, see setDefaultTimeout(), the call returns
+ * with error code deadlineExceededErrorCode once the timeout has elapsed.
+ *
+ * \par Example
+ * \code {.cpp}
+ * cbe::delegate::QueryDelegate::ErrorInfo error{};
+ * auto result = cbe::util::callSync<cbe::delegate::QueryDelegate>(
+ *                 [&](auto delegate) { container.query(filter, delegate); },
+ *                 error);
+ * if (!result) {
+ *   std::cerr << error;
+ * }
+ * \endcode
+ *
+ * \note Must not be called from within a delegate callback, since that would
+ * block the SDK thread that is to deliver the response.
+ *
+ * @tparam DelegateT  Delegate interface of the asynchronous call.
+ * @param start       Invoked with a <code>std::shared_ptr<DelegateT></code>,
+ *                    and expected to make the asynchronous call with it.
+ * @param error       Out/return parameter receiving the error information
+ *                    should the call fail.
+ * @return Empty &mdash; i.e., <code><b>false</b></code> &mdash; indicates a
+ *         failed call, and the error information is passed out via the
+ *         \p error out/return parameter.
+ */
+template <class DelegateT, class StartFnT>
+cbe::util::Optional<typename DelegateT::Success> callSync(
+                                    StartFnT&&                      start,
+                                    typename DelegateT::ErrorInfo&  error) {
+  return callSync<DelegateT>(std::forward<StartFnT>(start),
+                             impl::defaultDeadline(), error);
+}
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE_NO_SYNC
+
+#endif // #ifndef CBE__util__Sync_h__
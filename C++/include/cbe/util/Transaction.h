@@ -0,0 +1,573 @@
+#ifndef CBE__util__Transaction_h__
+#define CBE__util__Transaction_h__
+
+#include "cbe/CloudBackend.h"
+#include "cbe/Container.h"
+#include "cbe/Filter.h"
+#include "cbe/Item.h"
+#include "cbe/Object.h"
+#include "cbe/QueryChain.h"
+#include "cbe/QueryResult.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/Error.h"
+#include "cbe/delegate/TransactionDelegate.h"
+#include "cbe/delegate/impl/FnDelegate.h"
+
+#include "cbe/util/Context.h"
+#include "cbe/util/Optional.h"
+#include "cbe/util/impl/AsyncWindow.h"
+#include "cbe/util/impl/SyncSignal.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+struct Mutation {
+  enum class Kind { CreateObject, UpdateKeyValues, Move, Rename, Remove };
+
+  explicit Mutation(Kind kind) : kind{kind} {}
+
+  Kind              kind;
+  cbe::Item         item{cbe::DefaultCtor{}};
+  cbe::Container    container{cbe::DefaultCtor{}};
+  std::string       name{};
+  cbe::KeyValues    keyValues{};
+  cbe::ContainerId  dstId{};
+  // State needed to compensate the mutation
+  std::string       previousName{};
+  cbe::KeyValues    previousKeyValues{};
+  cbe::ContainerId  previousParentId{};
+}; // struct Mutation
+
+struct Expectation {
+  Expectation() = default;
+  Expectation(cbe::ContainerId parentId, cbe::Date updated)
+    : parentId{parentId}, updated{updated} {}
+
+  cbe::ContainerId  parentId{};
+  cbe::Date         updated{};
+}; // struct Expectation
+
+class TransactionRun : public std::enable_shared_from_this<TransactionRun> {
+public:
+  using Error = delegate::Error;
+
+  TransactionRun(cbe::CloudBackend                      cloudBackend,
+                 std::vector<Mutation>                  mutations,
+                 std::map<cbe::ItemId, Expectation>     expectations,
+                 delegate::TransactionDelegatePtr       delegate)
+    : cloudBackend{std::move(cloudBackend)}, mutations{std::move(mutations)},
+      expectations{std::move(expectations)}, delegate{std::move(delegate)} {
+    for (std::size_t index = 0; index < this->mutations.size(); ++index) {
+      if (this->mutations[index].kind != Mutation::Kind::Remove) {
+        order.push_back(index);
+      }
+    }
+    // Removals cannot be compensated, hence they are applied last
+    for (std::size_t index = 0; index < this->mutations.size(); ++index) {
+      if (this->mutations[index].kind == Mutation::Kind::Remove) {
+        order.push_back(index);
+      }
+    }
+    success.items.assign(this->mutations.size(), cbe::Item{cbe::DefaultCtor{}});
+  }
+
+  TransactionRun(const TransactionRun&) = delete;
+  TransactionRun& operator=(const TransactionRun&) = delete;
+
+  void start() {
+    auto self = shared_from_this();
+    std::map<cbe::ContainerId, std::set<cbe::ItemId>> byParent{};
+    for (const auto& expectation : expectations) {
+      byParent[expectation.second.parentId].insert(expectation.first);
+    }
+    window = std::make_shared<AsyncWindow>(byParent.size() + 1,
+                                           [self]() { self->verified(); });
+    // Holds a slot until all the checks are posted, lest a check completing
+    // inline drains the window early
+    auto guard = window;
+    guard->post([]() {});
+    for (auto& parent : byParent) {
+      verify(parent.first, std::move(parent.second), 0 /* offset */);
+    }
+    guard->complete();
+  }
+
+private:
+  static constexpr std::uint32_t pageSize = 1000;
+
+  // Success callback of a compensating call, whatever its success type
+  struct Compensated {
+    std::shared_ptr<TransactionRun> self;
+    std::size_t                     position;
+
+    template <class SuccessT>
+    void operator()(SuccessT&&) const { self->compensate(position); }
+  }; // struct Compensated
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  // Phase 1: optimistic concurrency check of the updated() dates, bypassing
+  // the cache
+  void verify(cbe::ContainerId        parentId,
+              std::set<cbe::ItemId>   pending,
+              std::uint32_t           offset) {
+    auto self = shared_from_this();
+    window->post([self, parentId, pending, offset]() mutable {
+      auto filter = cbe::Filter{}.setByPassCache(true)
+                                 .setOffset(offset)
+                                 .setCount(pageSize);
+      self->cloudBackend.query(
+        parentId, std::move(filter),
+        delegate::impl::makeFnDelegate<delegate::QueryDelegate>(
+          [self, parentId, pending, offset](
+                                      cbe::QueryResult&& queryResult) mutable {
+            for (const auto& item : queryResult.getItemsSnapshot()) {
+              auto found = pending.find(item.id());
+              if (found == pending.end()) {
+                continue;
+              }
+              pending.erase(found);
+              const auto& expected = self->expectations.at(item.id());
+              if (item.updated() != expected.updated) {
+                self->conflict(item.id(), "Item updated by someone else");
+              }
+            }
+            const auto loaded = queryResult.itemsLoaded();
+            if (!pending.empty()) {
+              if (loaded && offset + loaded < queryResult.totalCount()) {
+                self->verify(parentId, std::move(pending),
+                             static_cast<std::uint32_t>(offset + loaded));
+              } else {
+                self->conflict(*pending.begin(), "Item moved or removed");
+              }
+            }
+            self->window->complete();
+          },
+          [self](delegate::QueryError&& error, cbe::util::Context&& context) {
+            self->setFailure(self->mutations.size(), 0, std::move(error),
+                             std::move(context));
+            self->window->complete();
+          }));
+    });
+  }
+
+  void conflict(cbe::ItemId itemId, const char* message) {
+    setFailure(mutations.size(), itemId,
+               Error{412, "Precondition Failed", message}, cbe::util::Context{});
+  }
+
+  void verified() {
+    window.reset();
+    if (failed) {
+      report();
+    } else {
+      applyNext(0);
+    }
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  // Phase 2: the mutations, one at a time
+  void applyNext(std::size_t position) {
+    if (position == order.size()) {
+      delegate->onTransactionSuccess(std::move(success));
+      return;
+    }
+    auto self = shared_from_this();
+    auto& mutation = mutations[order[position]];
+    auto onFailure = [self, position](Error&& error,
+                                      cbe::util::Context&& context) {
+      self->failedAt(position, std::move(error), std::move(context));
+    };
+    auto onApplied = [self, position](cbe::Item&& item) {
+      self->success.items[self->order[position]] = std::move(item);
+      self->applyNext(position + 1);
+    };
+    const bool isContainer = mutation.item.type() == cbe::ItemType::Container;
+    switch (mutation.kind) {
+    case Mutation::Kind::CreateObject:
+      mutation.container.createObject(
+        mutation.name, mutation.keyValues,
+        delegate::impl::makeFnDelegate<delegate::CreateObjectDelegate>(
+          onApplied, onFailure));
+      break;
+    case Mutation::Kind::UpdateKeyValues:
+      cbe::CloudBackend::castObject(mutation.item).updateKeyValues(
+        mutation.keyValues,
+        delegate::impl::makeFnDelegate<delegate::UpdateKeyValuesDelegate>(
+          onApplied, onFailure));
+      break;
+    case Mutation::Kind::Move:
+      if (isContainer) {
+        cbe::CloudBackend::castContainer(mutation.item).move(
+          mutation.dstId,
+          delegate::impl::makeFnDelegate<delegate::container::MoveDelegate>(
+            onApplied, onFailure));
+      } else {
+        cbe::CloudBackend::castObject(mutation.item).move(
+          mutation.dstId,
+          delegate::impl::makeFnDelegate<delegate::object::MoveDelegate>(
+            onApplied, onFailure));
+      }
+      break;
+    case Mutation::Kind::Rename:
+      if (isContainer) {
+        cbe::CloudBackend::castContainer(mutation.item).rename(
+          mutation.name,
+          delegate::impl::makeFnDelegate<delegate::container::RenameDelegate>(
+            onApplied, onFailure));
+      } else {
+        cbe::CloudBackend::castObject(mutation.item).rename(
+          mutation.name,
+          delegate::impl::makeFnDelegate<delegate::object::RenameDelegate>(
+            onApplied, onFailure));
+      }
+      break;
+    case Mutation::Kind::Remove:
+      if (isContainer) {
+        cbe::CloudBackend::castContainer(mutation.item).remove(
+          delegate::impl::makeFnDelegate<delegate::container::RemoveDelegate>(
+            [self, position](delegate::container::RemoveSuccess&&) {
+              self->applyNext(position + 1);
+            },
+            onFailure));
+      } else {
+        cbe::CloudBackend::castObject(mutation.item).remove(
+          delegate::impl::makeFnDelegate<delegate::object::RemoveDelegate>(
+            [self, position](delegate::object::RemoveSuccess&&) {
+              self->applyNext(position + 1);
+            },
+            onFailure));
+      }
+      break;
+    }
+  }
+
+  void failedAt(std::size_t           position,
+                Error&&               error,
+                cbe::util::Context&&  context) {
+    const auto& mutation = mutations[order[position]];
+    setFailure(order[position], mutation.item.id(), std::move(error),
+               std::move(context));
+    // Removals are applied last, so if a removal has been applied, all
+    // mutations before the failing one are removals
+    if (position && mutations[order[position - 1]].kind
+                                                  == Mutation::Kind::Remove) {
+      rolledBack = false;
+    }
+    compensate(position);
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  // Phase 3: compensation of the applied mutations, in reverse order
+  void compensate(std::size_t position) {
+    while (position && mutations[order[position - 1]].kind
+                                                  == Mutation::Kind::Remove) {
+      --position;
+    }
+    if (!position) {
+      report();
+      return;
+    }
+    --position;
+    auto self = shared_from_this();
+    const auto& mutation = mutations[order[position]];
+    auto result = success.items[order[position]];
+    const Compensated next{self, position};
+    auto onFailure = [self, position](Error&&, cbe::util::Context&&) {
+      self->rolledBack = false;
+      self->compensate(position);
+    };
+    const bool isContainer = result.type() == cbe::ItemType::Container;
+    switch (mutation.kind) {
+    case Mutation::Kind::CreateObject:
+      cbe::CloudBackend::castObject(result).remove(
+        delegate::impl::makeFnDelegate<delegate::object::RemoveDelegate>(
+          next, onFailure));
+      break;
+    case Mutation::Kind::UpdateKeyValues:
+      cbe::CloudBackend::castObject(result).updateKeyValues(
+        mutation.previousKeyValues,
+        delegate::impl::makeFnDelegate<delegate::UpdateKeyValuesDelegate>(
+          next, onFailure));
+      break;
+    case Mutation::Kind::Move:
+      if (isContainer) {
+        cbe::CloudBackend::castContainer(result).move(
+          mutation.previousParentId,
+          delegate::impl::makeFnDelegate<delegate::container::MoveDelegate>(
+            next, onFailure));
+      } else {
+        cbe::CloudBackend::castObject(result).move(
+          mutation.previousParentId,
+          delegate::impl::makeFnDelegate<delegate::object::MoveDelegate>(
+            next, onFailure));
+      }
+      break;
+    case Mutation::Kind::Rename:
+      if (isContainer) {
+        cbe::CloudBackend::castContainer(result).rename(
+          mutation.previousName,
+          delegate::impl::makeFnDelegate<delegate::container::RenameDelegate>(
+            next, onFailure));
+      } else {
+        cbe::CloudBackend::castObject(result).rename(
+          mutation.previousName,
+          delegate::impl::makeFnDelegate<delegate::object::RenameDelegate>(
+            next, onFailure));
+      }
+      break;
+    case Mutation::Kind::Remove:
+      compensate(position); // Not reached, removals are skipped above
+      break;
+    }
+  }
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  void setFailure(std::size_t           failedIndex,
+                  cbe::ItemId           itemId,
+                  Error&&               error,
+                  cbe::util::Context&&  context) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (!failed) {
+      failed = true;
+      failure = delegate::TransactionError{std::move(error), failedIndex,
+                                           itemId, true /* rolledBack */};
+      failureContext = std::move(context);
+    }
+  }
+
+  void report() {
+    failure.rolledBack = rolledBack;
+    const auto size = mutations.size();
+    auto inner = std::move(failureContext);
+    delegate->onTransactionError(
+      std::move(failure),
+      cbe::util::Context{[size, inner](std::ostream& os) {
+                           os << "mutations=" << size << '\n' << inner;
+                         },
+                         "Transaction::commit"});
+  }
+
+  std::mutex                            mutex{};
+  cbe::CloudBackend                     cloudBackend;
+  std::vector<Mutation>                 mutations;
+  std::map<cbe::ItemId, Expectation>    expectations;
+  delegate::TransactionDelegatePtr      delegate;
+  std::vector<std::size_t>              order{};
+  std::shared_ptr<AsyncWindow>          window{};
+  delegate::TransactionSuccess          success{};
+  bool                                  failed{};
+  bool                                  rolledBack{true};
+  delegate::TransactionError            failure{};
+  cbe::util::Context                    failureContext{};
+}; // class TransactionRun
+
+#ifndef CBE_NO_SYNC
+class TransactionWaiter : public delegate::TransactionDelegate {
+public:
+  cbe::util::Optional<delegate::TransactionSuccess> wait(ErrorInfo& error) {
+    signal.wait();
+    if (!result) {
+      error = std::move(errorInfo);
+    }
+    return std::move(result);
+  }
+private:
+  void onTransactionSuccess(delegate::TransactionSuccess&& success) override {
+    result = std::move(success);
+    signal.notify();
+  }
+  void onTransactionError(Error&& error, cbe::util::Context&& context) override {
+    errorInfo = ErrorInfo{std::move(context), std::move(error)};
+    signal.notify();
+  }
+
+  SyncSignal                                        signal{};
+  cbe::util::Optional<delegate::TransactionSuccess> result{};
+  ErrorInfo                                         errorInfo{};
+}; // class TransactionWaiter
+#endif // #ifndef CBE_NO_SYNC
+
+    } // namespace impl
+
+/**
+ * @brief A list of mutations applied all-or-nothing, with optimistic
+ *        concurrency control on the @ref cbe::Item::updated() "updated()" dates.
+ *
+ * The mutations are collected with the builder methods and applied by
+ * commit(), which runs in three phases:
+ * <ol>
+ *   <li> Every existing item touched by a mutation, and every item passed to
+ *        expectUnchanged(), is looked up in its parent container, bypassing
+ *        the cache. If any of them has been updated, moved or removed since it
+ *        was read, the transaction fails with error code 412 and nothing is
+ *        applied.
+ *   <li> The mutations are applied one at a time, in the order they were
+ *        added, except removals that are applied last.
+ *   <li> Should a mutation fail, the mutations already applied are compensated
+ *        in reverse order: created objects are removed, key/values, names and
+ *        parents are restored.
+ * </ol>
+ *
+ * \note The transaction is atomic with respect to failures, not isolated:
+ * other clients may observe the intermediate states while it is applied, and
+ * a change made by someone else between phase 1 and 2 is not detected.
+ * A removal cannot be compensated, hence
+ * delegate::TransactionError::rolledBack is \c false if a transaction fails
+ * after one of its removals has been applied.
+ *
+ * \par Example
+ * \code {.cpp}
+ * cbe::util::Transaction transaction{};
+ * transaction.createObject(container, "order-17", {{"state", {"new", true}}})
+ *            .updateKeyValues(indexObject, indexKeyValues)
+ *            .move(draft, archiveContainerId);
+ * transaction.commit(cloudBackend, transactionDelegate);
+ * \endcode
+ */
+class Transaction {
+public:
+  /**
+   * Makes the transaction conditional on \p item being unchanged, i.e., it
+   * still resides in the same container with the same updated() date as when
+   * it was read. Items touched by the mutations are checked implicitly.
+   */
+  Transaction& expectUnchanged(const cbe::Item& item) {
+    expectations.emplace(item.id(),
+                         impl::Expectation{item.parentId(), item.updated()});
+    return *this;
+  }
+
+  /**
+   * Adds the creation of an object named \p name in \p container.
+   * See cbe::Container::createObject().
+   */
+  Transaction& createObject(cbe::Container  container,
+                            std::string     name,
+                            cbe::KeyValues  keyValues) {
+    impl::Mutation mutation{impl::Mutation::Kind::CreateObject};
+    mutation.container = std::move(container);
+    mutation.name = std::move(name);
+    mutation.keyValues = std::move(keyValues);
+    mutations.push_back(std::move(mutation));
+    return *this;
+  }
+
+  /**
+   * Adds an update of the key/values of \p object.
+   * See cbe::Object::updateKeyValues().
+   */
+  Transaction& updateKeyValues(cbe::Object object, cbe::KeyValues keyValues) {
+    impl::Mutation mutation{impl::Mutation::Kind::UpdateKeyValues};
+    mutation.previousKeyValues = object.keyValues();
+    mutation.keyValues = std::move(keyValues);
+    return add(std::move(mutation), object);
+  }
+
+  /**
+   * Adds a move of the container or object \p item to container \p dstId.
+   */
+  Transaction& move(const cbe::Item& item, cbe::ContainerId dstId) {
+    impl::Mutation mutation{impl::Mutation::Kind::Move};
+    mutation.dstId = dstId;
+    return add(std::move(mutation), item);
+  }
+
+  /**
+   * Adds a rename of the container or object \p item.
+   */
+  Transaction& rename(const cbe::Item& item, std::string name) {
+    impl::Mutation mutation{impl::Mutation::Kind::Rename};
+    mutation.name = std::move(name);
+    return add(std::move(mutation), item);
+  }
+
+  /**
+   * Adds the removal of the container or object \p item.
+   */
+  Transaction& remove(const cbe::Item& item) {
+    return add(impl::Mutation{impl::Mutation::Kind::Remove}, item);
+  }
+
+  /**
+   * Number of mutations added.
+   */
+  std::size_t size() const { return mutations.size(); }
+
+  /**
+   * @brief Applies the transaction.
+   *
+   * The transaction itself is left unchanged, and may be committed again,
+   * e.g., after a failure with error code 412 once the items have been re-read.
+   *
+   * @param cloudBackend  The session used for the concurrency check.
+   * @param delegate      Pointer to a delegate::TransactionDelegate instance
+   *                      that is implemented by the user.
+   */
+  void commit(cbe::CloudBackend                 cloudBackend,
+              delegate::TransactionDelegatePtr  delegate) const {
+    auto run = std::make_shared<impl::TransactionRun>(std::move(cloudBackend),
+                                                      mutations, expectations,
+                                                      std::move(delegate));
+    run->start();
+  }
+
+#ifndef CBE_NO_SYNC
+  /**
+   * Forms the type of the \p error return parameter for the synchronous version
+   * of method
+   * @ref commit(cbe::CloudBackend,TransactionError&) "commit()"
+   * <br>See delegate::TransactionDelegate::ErrorInfo
+   */
+  using TransactionError = delegate::TransactionDelegate::ErrorInfo;
+  /**
+   * @brief Synchronous [non-throwing] commit
+   *
+   * <b>Synchronous</b> version of
+   * commit(cbe::CloudBackend,delegate::TransactionDelegatePtr)
+   * , and <b>throws <u>no</u> exception</b> on error, instead the out/return
+   * parameter \p error is used to provide the error information in connection
+   * with a failed call.
+   *
+   * @return Empty &mdash; i.e., <code><b>false</b></code> &mdash; indicates a
+   *         failed call, and the error information is passed out via the
+   *         \p error out/return parameter.
+   */
+  cbe::util::Optional<delegate::TransactionSuccess> commit(
+                                          cbe::CloudBackend cloudBackend,
+                                          TransactionError& error) const {
+    auto waiter = std::make_shared<impl::TransactionWaiter>();
+    commit(std::move(cloudBackend), waiter);
+    return waiter->wait(error);
+  }
+#endif // #ifndef CBE_NO_SYNC
+
+private:
+  Transaction& add(impl::Mutation&& mutation, const cbe::Item& item) {
+    mutation.item = item;
+    mutation.previousName = item.name();
+    mutation.previousParentId = item.parentId();
+    mutations.push_back(std::move(mutation));
+    return expectUnchanged(item);
+  }
+
+  std::vector<impl::Mutation>               mutations{};
+  std::map<cbe::ItemId, impl::Expectation>  expectations{};
+}; // class Transaction
+
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__Transaction_h__
@@ -0,0 +1,116 @@
+#ifndef CBE__util__impl__AsyncWindow_h__
+#define CBE__util__impl__AsyncWindow_h__
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+/**
+ * @brief Runs queued asynchronous tasks with a bounded number in flight.
+ *
+ * A task is started by the window and is considered in flight until it calls
+ * complete(), typically from the delegate callback of the service call the task
+ * has issued. Once nothing is queued or in flight the \c onDrained callback is
+ * invoked, exactly once.
+ *
+ * After stop() no further queued tasks are started, but the tasks in flight
+ * still have to complete() before the window is drained.
+ */
+class AsyncWindow {
+public:
+  using Task = std::function<void()>;
+
+  AsyncWindow(std::size_t maxInFlight, std::function<void()> onDrained)
+    : maxInFlight{maxInFlight ? maxInFlight : 1},
+      onDrained{std::move(onDrained)} {}
+
+  AsyncWindow(const AsyncWindow&) = delete;
+  AsyncWindow& operator=(const AsyncWindow&) = delete;
+
+  /**
+   * Queues \p task and starts it directly if the window has room for it.
+   */
+  void post(Task task) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (stopped_) {
+        return;
+      }
+      queue.push_back(std::move(task));
+    }
+    pump();
+  }
+
+  /**
+   * Marks one task in flight as done, and starts queued tasks in its place.
+   */
+  void complete() {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      --inFlight;
+    }
+    pump();
+  }
+
+  /**
+   * Drops all queued tasks, and prevents new ones from being started.
+   */
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      stopped_ = true;
+      queue.clear();
+    }
+    pump();
+  }
+
+  bool stopped() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return stopped_;
+  }
+
+private:
+  void pump() {
+    std::vector<Task>     tasks{};
+    std::function<void()> drained{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      while (!queue.empty() && inFlight < maxInFlight) {
+        tasks.push_back(std::move(queue.front()));
+        queue.pop_front();
+        ++inFlight;
+      }
+      if (tasks.empty() && queue.empty() && !inFlight && onDrained) {
+        drained = std::move(onDrained);
+        onDrained = nullptr;
+      }
+    }
+    for (auto& task : tasks) {
+      task();
+    }
+    if (drained) {
+      drained();
+    }
+  }
+
+  mutable std::mutex    mutex{};
+  const std::size_t     maxInFlight;
+  std::size_t           inFlight{};
+  bool                  stopped_{};
+  std::deque<Task>      queue{};
+  std::function<void()> onDrained;
+}; // class AsyncWindow
+
+    } // namespace impl
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__impl__AsyncWindow_h__
@@ -0,0 +1,157 @@
+#ifndef CBE__util__impl__ChangeEventListener_h__
+#define CBE__util__impl__ChangeEventListener_h__
+
+#include "cbe/CloudBackend.h"
+#include "cbe/Container.h"
+#include "cbe/Item.h"
+#include "cbe/Object.h"
+#include "cbe/Types.h"
+
+#include "cbe/delegate/ChangeEvent.h"
+#include "cbe/delegate/CloudBackendListenerDelegate.h"
+
+#include <string>
+#include <utility>
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+/**
+ * @brief Listener that turns each callback of CloudBackendListenerDelegate
+ *        into a delegate::ChangeEvent passed to onChange().
+ */
+class ChangeEventListener : public delegate::CloudBackendListenerDelegate {
+public:
+  using ChangeEvent = delegate::ChangeEvent;
+
+  void onRemoteObjectAdded(cbe::Object&& object) override {
+    onChange(changed(ChangeEvent::Added, cbe::ItemType::Object,
+                     std::move(object)));
+  }
+  void onRemoteObjectMoved(cbe::Object&& object) override {
+    onChange(changed(ChangeEvent::Moved, cbe::ItemType::Object,
+                     std::move(object)));
+  }
+  void onRemoteObjectRemoved(cbe::ItemId objectId, std::string name) override {
+    onChange(removed(cbe::ItemType::Object, objectId, std::move(name)));
+  }
+  void onRemoteObjectRenamed(cbe::Object&& object) override {
+    onChange(changed(ChangeEvent::Renamed, cbe::ItemType::Object,
+                     std::move(object)));
+  }
+  void onRemoteContainerAdded(cbe::Container&& container) override {
+    onChange(changed(ChangeEvent::Added, cbe::ItemType::Container,
+                     std::move(container)));
+  }
+  void onRemoteContainerMoved(cbe::Container&& container) override {
+    onChange(changed(ChangeEvent::Moved, cbe::ItemType::Container,
+                     std::move(container)));
+  }
+  void onRemoteContainerRemoved(cbe::ItemId containerId,
+                                std::string name) override {
+    onChange(removed(cbe::ItemType::Container, containerId, std::move(name)));
+  }
+  void onRemoteContainerRenamed(cbe::Container&& container) override {
+    onChange(changed(ChangeEvent::Renamed, cbe::ItemType::Container,
+                     std::move(container)));
+  }
+
+protected:
+  virtual void onChange(ChangeEvent&& event) = 0;
+
+private:
+  static ChangeEvent changed(ChangeEvent::Kind kind, cbe::ItemType itemType,
+                             cbe::Item&& item) {
+    ChangeEvent event{};
+    event.kinds = kind;
+    event.itemType = itemType;
+    event.itemId = item.id();
+    event.name = item.name();
+    event.item = std::move(item);
+    return event;
+  }
+
+  static ChangeEvent removed(cbe::ItemType itemType, cbe::ItemId itemId,
+                             std::string&& name) {
+    ChangeEvent event{};
+    event.kinds = ChangeEvent::Removed;
+    event.itemType = itemType;
+    event.itemId = itemId;
+    event.name = std::move(name);
+    return event;
+  }
+}; // class ChangeEventListener
+
+/**
+ * Merges \p event into \p pending, an earlier change of the same item:
+ * <ul>
+ *   <li> the kinds of the changes are combined, and the latest state kept,
+ *   <li> a removal supersedes the earlier moves and renames,
+ *   <li> an item both added and removed is left with no kinds at all.
+ * </ul>
+ */
+inline void coalesce(delegate::ChangeEvent& pending,
+                     delegate::ChangeEvent&& event) {
+  using ChangeEvent = delegate::ChangeEvent;
+  if (event.is(ChangeEvent::Removed)) {
+    pending.kinds = pending.is(ChangeEvent::Added) ? 0 : event.kinds;
+  } else if (pending.is(ChangeEvent::Removed) || !pending.kinds) {
+    pending.kinds = event.kinds;
+  } else {
+    pending.kinds |= event.kinds;
+  }
+  pending.name = std::move(event.name);
+  pending.item = std::move(event.item);
+}
+
+/**
+ * Makes the calls on \p listener that \p event stands for: the removal, or
+ * else the addition, or else the move and the rename, with the latest state.
+ */
+inline void deliver(delegate::ChangeEvent&&                 event,
+                    delegate::CloudBackendListenerDelegate& listener) {
+  using ChangeEvent = delegate::ChangeEvent;
+  const bool isObject = event.itemType == cbe::ItemType::Object;
+  if (event.is(ChangeEvent::Removed)) {
+    if (isObject) {
+      listener.onRemoteObjectRemoved(event.itemId, std::move(event.name));
+    } else {
+      listener.onRemoteContainerRemoved(event.itemId, std::move(event.name));
+    }
+    return;
+  }
+  if (isObject) {
+    if (event.is(ChangeEvent::Added)) {
+      listener.onRemoteObjectAdded(cbe::CloudBackend::castObject(event.item));
+      return;
+    }
+    if (event.is(ChangeEvent::Moved)) {
+      listener.onRemoteObjectMoved(cbe::CloudBackend::castObject(event.item));
+    }
+    if (event.is(ChangeEvent::Renamed)) {
+      listener.onRemoteObjectRenamed(
+        cbe::CloudBackend::castObject(event.item));
+    }
+    return;
+  }
+  if (event.is(ChangeEvent::Added)) {
+    listener.onRemoteContainerAdded(
+      cbe::CloudBackend::castContainer(event.item));
+    return;
+  }
+  if (event.is(ChangeEvent::Moved)) {
+    listener.onRemoteContainerMoved(
+      cbe::CloudBackend::castContainer(event.item));
+  }
+  if (event.is(ChangeEvent::Renamed)) {
+    listener.onRemoteContainerRenamed(
+      cbe::CloudBackend::castContainer(event.item));
+  }
+}
+
+    } // namespace impl
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__impl__ChangeEventListener_h__
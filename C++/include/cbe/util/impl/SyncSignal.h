@@ -0,0 +1,65 @@
+#ifndef CBE__util__impl__SyncSignal_h__
+#define CBE__util__impl__SyncSignal_h__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+/**
+ * @brief One-shot event that a synchronous call blocks on until the delegate
+ *        of the underlying asynchronous call has been called back.
+ *
+ * wait() first spins for a short while, yielding, and only then blocks on a
+ * condition variable. Responses served from the cache therefore wake the
+ * caller without a mutex or condition variable round trip, and notify() only
+ * takes the mutex if the caller is actually asleep.
+ *
+ * Writes made before notify() are visible to the caller after wait() returns.
+ * The object must outlive notify(), e.g., by being owned by the delegate.
+ */
+class SyncSignal {
+public:
+  SyncSignal() = default;
+  SyncSignal(const SyncSignal&) = delete;
+  SyncSignal& operator=(const SyncSignal&) = delete;
+
+  void notify() {
+    ready.store(true);
+    if (sleeping.load()) {
+      std::lock_guard<std::mutex> lock{mutex};
+      conditionVariable.notify_one();
+    }
+  }
+
+  void wait() {
+    const std::chrono::microseconds spinDuration{50};
+    const auto spinUntil = std::chrono::steady_clock::now() + spinDuration;
+    while (!ready.load(std::memory_order_acquire)) {
+      if (std::chrono::steady_clock::now() >= spinUntil) {
+        std::unique_lock<std::mutex> lock{mutex};
+        sleeping.store(true);
+        conditionVariable.wait(lock, [this] { return ready.load(); });
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+private:
+  std::atomic<bool>       ready{false};
+  std::atomic<bool>       sleeping{false};
+  std::mutex              mutex{};
+  std::condition_variable conditionVariable{};
+}; // class SyncSignal
+
+    } // namespace impl
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__impl__SyncSignal_h__
@@ -0,0 +1,112 @@
+#ifndef CBE__util__impl__Timer_h__
+#define CBE__util__impl__Timer_h__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace cbe {
+  namespace util {
+    namespace impl {
+
+/**
+ * @brief Runs callbacks at points in time, on a single background thread.
+ *
+ * The thread is started on first use, and the instance lives until the
+ * process exits, so that timers may be unscheduled from static destructors.
+ * Callbacks are run without any lock held and must be short, e.g., cancel a
+ * CancellationSource.
+ */
+class Timer {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Callback = std::function<void()>;
+  using Id = std::uint64_t;
+
+  static Timer& instance() {
+    static Timer* const timer = new Timer{};
+    return *timer;
+  }
+
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
+
+  Id schedule(Clock::time_point at, Callback callback) {
+    Id id{};
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (!started) {
+        std::thread{[this]() { run(); }}.detach();
+        started = true;
+      }
+      id = ++lastId;
+      times.emplace(id, at);
+      timers.emplace(Key{at, id}, std::move(callback));
+    }
+    conditionVariable.notify_one();
+    return id;
+  }
+
+  /**
+   * Removes the timer unless it has already fired.
+   */
+  void unschedule(Id id) {
+    Callback removed{};
+    std::lock_guard<std::mutex> lock{mutex};
+    auto time = times.find(id);
+    if (time == times.end()) {
+      return;
+    }
+    auto timer = timers.find(Key{time->second, id});
+    removed = std::move(timer->second);
+    timers.erase(timer);
+    times.erase(time);
+  }
+
+private:
+  using Key = std::pair<Clock::time_point, Id>;
+
+  Timer() = default;
+
+  void run() {
+    std::unique_lock<std::mutex> lock{mutex};
+    for (;;) {
+      if (timers.empty()) {
+        conditionVariable.wait(lock);
+        continue;
+      }
+      auto next = timers.begin();
+      // By value, the timer may be unscheduled while waiting
+      const auto at = next->first.first;
+      if (Clock::now() < at) {
+        conditionVariable.wait_until(lock, at);
+        continue;
+      }
+      auto callback = std::move(next->second);
+      times.erase(next->first.second);
+      timers.erase(next);
+      lock.unlock();
+      callback();
+      callback = nullptr;
+      lock.lock();
+    }
+  }
+
+  std::mutex                      mutex{};
+  std::condition_variable         conditionVariable{};
+  bool                            started{};
+  Id                              lastId{};
+  std::map<Key, Callback>         timers{};
+  std::map<Id, Clock::time_point> times{};
+}; // class Timer
+
+    } // namespace impl
+  } // namespace util
+} // namespace cbe
+
+#endif // #ifndef CBE__util__impl__Timer_h__